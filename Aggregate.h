@@ -0,0 +1,95 @@
+/** @file Aggregate.h
+ * Aggregate policies for TreeMap.
+ *
+ * A policy describes a monoid over the values of a map: a Type, its
+ * identity(), lift(value) to turn one value into an aggregate, and an
+ * associative combine(a, b), where a covers smaller keys than b. TreeMap
+ * caches the aggregate of every subtree and answers aggregate(lo, hi) in
+ * O(log n). Any struct with these four members can be used as a policy.
+ */
+#ifndef __AGGREGATE_H
+#define __AGGREGATE_H
+
+#include <limits>
+#include <type_traits>
+
+/**
+ * The default policy: no aggregate, and no extra space in the nodes.
+ */
+template<class V>
+struct NoAggregate
+{
+    struct Type{};
+    static Type identity() { return Type(); }
+    static Type lift(const V&) { return Type(); }
+    static Type combine(const Type&, const Type&) { return Type(); }
+};
+
+/**
+ * Sum of the values, with V() as zero.
+ */
+template<class V>
+struct SumAggregate
+{
+    typedef V Type;
+    static Type identity() { return V(); }
+    static Type lift(const V& v) { return v; }
+    static Type combine(const Type& a, const Type& b) { return a + b; }
+};
+
+/**
+ * Least value; an empty range gives the greatest value of V.
+ */
+template<class V>
+struct MinAggregate
+{
+    typedef V Type;
+    static Type identity() { return std::numeric_limits<V>::max(); }
+    static Type lift(const V& v) { return v; }
+    static Type combine(const Type& a, const Type& b) { return b < a ? b : a; }
+};
+
+/**
+ * Greatest value; an empty range gives the lowest value of V.
+ */
+template<class V>
+struct MaxAggregate
+{
+    typedef V Type;
+    static Type identity() { return std::numeric_limits<V>::lowest(); }
+    static Type lift(const V& v) { return v; }
+    static Type combine(const Type& a, const Type& b) { return a < b ? b : a; }
+};
+
+/**
+ * Number of mappings.
+ */
+template<class V>
+struct CountAggregate
+{
+    typedef int Type;
+    static Type identity() { return 0; }
+    static Type lift(const V&) { return 1; }
+    static Type combine(const Type& a, const Type& b) { return a + b; }
+};
+
+/**
+ * Holds the cached aggregate of a tree node. Empty types take no space
+ * when the node derives from the slot.
+ */
+template<class T, bool = std::is_empty<T>::value>
+struct AggregateSlot
+{
+    T agg;
+    const T& getAggregate() const { return agg; }
+    void setAggregate(const T& x) { agg = x; }
+};
+
+template<class T>
+struct AggregateSlot<T, true>
+{
+    T getAggregate() const { return T(); }
+    void setAggregate(const T&) {}
+};
+
+#endif
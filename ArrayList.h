@@ -2,34 +2,351 @@
 #ifndef __ARRAYLIST_H
 #define __ARRAYLIST_H
 
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#include "IllegalArgument.h"
 #include "IndexOutOfBound.h"
 #include "ElementNotExist.h"
+#include "ParallelSort.h"
+#include "SimdScan.h"
 
 /**
  * The ArrayList is just like vector in C++.
  * You should know that "capacity" here doesn't mean how many elements are now in this list, where it means
  * the length of the array of your internal implemention
  *
+ * The array is raw storage: only the first size() slots hold constructed
+ * elements, so an empty list allocates nothing and removed elements are
+ * destroyed right away. When it is full, the capacity is multiplied by the
+ * growth factor (2 by default) and the elements are moved over, or copied
+ * if their move constructor may throw.
+ *
+ * Trivially copyable element types, such as scalars and structs of them,
+ * are shifted with memmove and kept in malloc'd storage that grows with
+ * realloc, which can often extend the block in place.
+ *
+ * For arithmetic element types, contains, indexOf, lastIndexOf, count, min,
+ * max and sum run vector kernels from SimdScan.h, using AVX-512, AVX2 or
+ * SSE2 depending on the CPU.
+ *
+ * parallelSort splits the work over several threads, with ParallelSort.h:
+ * integral types are radix sorted and other types are merge sorted.
+ *
+ * With an inline capacity N > 0, the first N elements are kept inside the
+ * list object itself and the heap is only used once the list outgrows them.
+ * SmallArrayList<T, N> names such a list.
+ *
  * The iterator iterates in the order of the elements being loaded into this list
  */
-template <class T>
-class ArrayList
+/**
+ * Uninitialized room for the N inline elements of an ArrayList. Empty when
+ * N is 0, so a list without inline capacity is no larger than before.
+ */
+template<class T, int N>
+struct InlineBuffer
+{
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type iBuffer[N];
+    T *inlineBuffer() { return reinterpret_cast<T*>(iBuffer); }
+    const T *inlineBuffer() const { return reinterpret_cast<const T*>(iBuffer); }
+};
+
+template<class T>
+struct InlineBuffer<T, 0>
+{
+    T *inlineBuffer() { return NULL; }
+    const T *inlineBuffer() const { return NULL; }
+};
+
+template <class T, int N = 0>
+class ArrayList : private InlineBuffer<T, N>
 {
 private:
     T *iStorage;
     int iSize;
     int iCapacity;
-    inline void autoSpace(){
-        if (iCapacity<=iSize)
-            doubleSpace();
+    double iGrowthFactor;
+    
+    static const int iInitialCapacity = 8;
+    static const bool iTrivial = std::is_trivially_copyable<T>::value;
+    
+    static T *allocate(int n){
+        if(n == 0) return NULL;
+        if(!iTrivial) return static_cast<T*>(::operator new(n * sizeof(T)));
+        void *tmp = malloc(n * sizeof(T));
+        if(tmp == NULL) throw std::bad_alloc();
+        return static_cast<T*>(tmp);
+    }
+    
+    static void deallocate(T *p){
+        if(iTrivial) free(p);
+        else ::operator delete(p);
+    }
+    
+    bool isInline() const{
+        return N > 0 && iStorage == this->inlineBuffer();
+    }
+    
+    /**
+     * Frees the array unless it is the inline buffer.
+     */
+    void release(){
+        if(!isInline()) deallocate(iStorage);
+    }
+    
+    static void destroy(T *p, int n){
+        if(iTrivial) return;
+        for(int i=0; i<n; ++i) p[i].~T();
+    }
+    
+    /**
+     * Moves n elements from src to dst, which may overlap; trivial types only.
+     */
+    static void shift(T *dst, const T *src, int n){
+        if(n > 0) memmove(static_cast<void*>(dst), static_cast<const void*>(src), n * sizeof(T));
+    }
+    
+    /**
+     * Constructs the n elements of src in dst, moving them when that cannot
+     * throw and copying otherwise, then destroys src. If a copy throws, dst
+     * is cleaned up and src is left untouched.
+     */
+    static void relocate(T *src, int n, T *dst){
+        int i = 0;
+        try{
+            for(; i<n; ++i) new(dst + i) T(std::move_if_noexcept(src[i]));
+        }
+        catch(...){
+            destroy(dst, i);
+            throw;
+        }
+        destroy(src, n);
+    }
+    
+    /**
+     * Moves the elements into an array of capacity elements, or into the
+     * inline buffer if they fit there.
+     */
+    void reallocate(int capacity){
+        if(capacity < N) capacity = N;
+        if(iTrivial && !isInline() && capacity > N){
+            T *tmp = static_cast<T*>(realloc(static_cast<void*>(iStorage), capacity * sizeof(T)));
+            if(tmp == NULL) throw std::bad_alloc();
+            iStorage = tmp;
+            iCapacity = capacity;
+            return;
+        }
+        if(capacity == N && isInline()) return;
+        T *tmp = capacity == N ? this->inlineBuffer() : allocate(capacity);
+        try{
+            relocate(iStorage, iSize, tmp);
+        }
+        catch(...){
+            if(capacity != N) deallocate(tmp);
+            throw;
+        }
+        release();
+        iStorage = tmp;
+        iCapacity = capacity;
+    }
+    
+    int grownCapacity() const{
+        if(iCapacity == 0) return iInitialCapacity;
+        double grown = iCapacity * iGrowthFactor;
+        int capacity = grown < INT_MAX ? static_cast<int>(grown) : INT_MAX;
+        return capacity > iSize ? capacity : iSize + 1;
+    }
+    
+    /**
+     * Makes room for n elements, growing by at least the growth factor so
+     * that repeated bulk adds stay amortized O(1) per element.
+     */
+    void ensureCapacity(int n){
+        if(n <= iCapacity) return;
+        int capacity = grownCapacity();
+        reallocate(capacity > n ? capacity : n);
+    }
+    
+    /**
+     * Keeps the elements for which pred returns keep, in order, moving each
+     * survivor at most once. Returns the number of elements removed.
+     */
+    template<class F>
+    int filter(F& pred, bool keep){
+        int kept = 0;
+        for(int i=0; i<iSize; ++i){
+            if(static_cast<bool>(pred(iStorage[i])) != keep) continue;
+            if(kept != i) iStorage[kept] = std::move(iStorage[i]);
+            ++kept;
+        }
+        int removed = iSize - kept;
+        destroy(iStorage + kept, removed);
+        iSize = kept;
+        return removed;
+    }
+    
+    typedef std::integral_constant<bool, SimdScan<T>::enabled> Vectorized;
+    
+    int indexOf(const T& e, std::true_type) const{
+        return SimdScan<T>::indexOf(iStorage, iSize, e);
+    }
+    
+    int indexOf(const T& e, std::false_type) const{
+        for(int i=0; i<iSize; ++i)
+            if(iStorage[i] == e)
+                return i;
+        return -1;
+    }
+    
+    int lastIndexOf(const T& e, std::true_type) const{
+        return SimdScan<T>::lastIndexOf(iStorage, iSize, e);
+    }
+    
+    int lastIndexOf(const T& e, std::false_type) const{
+        for(int i=iSize-1; i>=0; --i)
+            if(iStorage[i] == e)
+                return i;
+        return -1;
+    }
+    
+    int count(const T& e, std::true_type) const{
+        return SimdScan<T>::count(iStorage, iSize, e);
+    }
+    
+    int count(const T& e, std::false_type) const{
+        int cnt = 0;
+        for(int i=0; i<iSize; ++i)
+            if(iStorage[i] == e)
+                ++cnt;
+        return cnt;
+    }
+    
+    template<bool Greatest>
+    T extreme(std::true_type) const{
+        return SimdScan<T>::template extreme<Greatest>(iStorage, iSize);
+    }
+    
+    template<bool Greatest>
+    T extreme(std::false_type) const{
+        const T *result = iStorage;
+        for(int i=1; i<iSize; ++i)
+            if(Greatest ? *result < iStorage[i] : iStorage[i] < *result)
+                result = iStorage + i;
+        return *result;
+    }
+    
+    typename SumOf<T>::Type sum(std::true_type) const{
+        return SimdScan<T>::sum(iStorage, iSize);
+    }
+    
+    typename SumOf<T>::Type sum(std::false_type) const{
+        typename SumOf<T>::Type result = typename SumOf<T>::Type();
+        for(int i=0; i<iSize; ++i)
+            result = result + iStorage[i];
+        return result;
+    }
+    
+    void parallelSort(int threads, std::true_type){
+        ParallelSort<T>::sortRadix(iStorage, iSize, threads);
+    }
+    
+    void parallelSort(int threads, std::false_type){
+        ParallelSort<T>::mergeSort(iStorage, iSize, std::less<T>(), threads);
+    }
+    
+    static int threadsOrCores(int threads){
+        if(threads > 0) return threads;
+        int cores = static_cast<int>(std::thread::hardware_concurrency());
+        return cores > 0 ? cores : 1;
+    }
+    
+    struct ContainedIn{
+        const ArrayList& list;
+        ContainedIn(const ArrayList& x):list(x){}
+        bool operator()(const T& e) const { return list.contains(e); }
+    };
+    
+    /**
+     * Constructs an element from args at the end of a full list. The new
+     * element is built before the old array is released, so args may refer
+     * to an element of this list.
+     */
+    template<class... Args>
+    void growAndEmplace(Args&&... args){
+        if(iTrivial){
+            T element(std::forward<Args>(args)...);
+            reallocate(grownCapacity());
+            new(iStorage + iSize) T(element);
+            return;
+        }
+        int capacity = grownCapacity();
+        T *tmp = allocate(capacity);
+        try{
+            new(tmp + iSize) T(std::forward<Args>(args)...);
+        }
+        catch(...){
+            deallocate(tmp);
+            throw;
+        }
+        try{
+            relocate(iStorage, iSize, tmp);
+        }
+        catch(...){
+            tmp[iSize].~T();
+            deallocate(tmp);
+            throw;
+        }
+        release();
+        iStorage = tmp;
+        iCapacity = capacity;
     }
-    void doubleSpace(){
-        T *tmp = iStorage;
-        iCapacity *= 2;
-        iStorage = new T[iCapacity];
-        for (int i=0;i<iSize;++i) iStorage[i] = tmp[i];
-        delete[] tmp;
+    
+    void copyFrom(const ArrayList& x){
+        if(x.iSize > N){
+            iStorage = allocate(x.iSize);
+            iCapacity = x.iSize;
+        }
+        if(iTrivial){
+            shift(iStorage, x.iStorage, x.iSize);
+            iSize = x.iSize;
+            return;
+        }
+        for(iSize = 0; iSize < x.iSize; ++iSize)
+            new(iStorage + iSize) T(x.iStorage[iSize]);
     }
+    
+    /**
+     * Takes the elements of x into this list, which must be empty and use
+     * its inline buffer. Inline elements are moved one by one; a heap array
+     * is taken over as a whole. x is left empty.
+     */
+    void takeFrom(ArrayList& x){
+        iGrowthFactor = x.iGrowthFactor;
+        if(x.isInline()){
+            relocate(x.iStorage, x.iSize, iStorage);
+            iSize = x.iSize;
+            x.iSize = 0;
+            return;
+        }
+        iStorage = x.iStorage;
+        iSize = x.iSize;
+        iCapacity = x.iCapacity;
+        x.iStorage = x.inlineBuffer();
+        x.iSize = 0;
+        x.iCapacity = N;
+    }
+    
+    static const bool iNothrowMove = N == 0 || std::is_nothrow_move_constructible<T>::value;
+
 public:
     class Iterator
     {
@@ -76,18 +393,18 @@ public:
     };
     
     /**
-     *  Constructs an empty array list.
+     *  Constructs an empty array list. Nothing is allocated until the first add
+     * beyond the inline capacity.
      */
     ArrayList()
-    :iSize(0),iCapacity(128){
-        iStorage = new T[iCapacity];
-    }
+    :iStorage(this->inlineBuffer()),iSize(0),iCapacity(N),iGrowthFactor(2){}
     
     /**
      *  Destructor
      */
     ~ArrayList() {
-        delete[] iStorage;
+        destroy(iStorage, iSize);
+        release();
     }
     
     /**
@@ -95,24 +412,64 @@ public:
      */
     ArrayList& operator=(const ArrayList& x) {
         if(this == &x) return *this;
-        delete[] iStorage;
-        iCapacity = x.iCapacity;
-        iSize = x.iSize;
-        iStorage = new T[iCapacity];
-        for (int i=0;i<iSize;++i)
-            iStorage[i] = x.iStorage[i];
+        ArrayList tmp(x);
+        swap(tmp);
         return *this;
     }
     
     /**
-     *  Copy-constructor
+     *  Copy-constructor. The copy has no spare capacity beyond the inline one.
      */
-    ArrayList(const ArrayList& x) {
-        iCapacity = x.iCapacity;
-        iSize = x.iSize;
-        iStorage = new T[iCapacity];
-        for (int i=0;i<iSize;++i)
-            iStorage[i] = x.iStorage[i];
+    ArrayList(const ArrayList& x)
+    :iStorage(this->inlineBuffer()),iSize(0),iCapacity(N),iGrowthFactor(x.iGrowthFactor) {
+        try{
+            copyFrom(x);
+        }
+        catch(...){
+            destroy(iStorage, iSize);
+            release();
+            throw;
+        }
+    }
+    
+    /**
+     *  Move-constructor. x is left empty. Elements held inline by x are moved
+     * one by one, so this only cannot throw if their move constructor cannot.
+     */
+    ArrayList(ArrayList&& x) noexcept(iNothrowMove)
+    :iStorage(this->inlineBuffer()),iSize(0),iCapacity(N),iGrowthFactor(x.iGrowthFactor) {
+        takeFrom(x);
+    }
+    
+    /**
+     *  Move assignment operator. x is left empty.
+     */
+    ArrayList& operator=(ArrayList&& x) noexcept(iNothrowMove) {
+        if(this == &x) return *this;
+        destroy(iStorage, iSize);
+        release();
+        iStorage = this->inlineBuffer();
+        iSize = 0;
+        iCapacity = N;
+        takeFrom(x);
+        return *this;
+    }
+    
+    /**
+     *  Exchanges the contents of this list and x, in O(1) unless one of them
+     * holds its elements inline.
+     */
+    void swap(ArrayList& x) noexcept(iNothrowMove) {
+        if(isInline() || x.isInline()){
+            ArrayList tmp(std::move(x));
+            x = std::move(*this);
+            *this = std::move(tmp);
+            return;
+        }
+        std::swap(iStorage, x.iStorage);
+        std::swap(iSize, x.iSize);
+        std::swap(iCapacity, x.iCapacity);
+        std::swap(iGrowthFactor, x.iGrowthFactor);
     }
     
     /**
@@ -120,11 +477,29 @@ public:
      * Always returns true.
      */
     bool add(const T& e) {
-        autoSpace();
-        iStorage[iSize++] = e;
+        emplace(e);
         return  true;
     }
     
+    /**
+     *  Appends the specified element to the end of this list, moving it in.
+     * Always returns true.
+     */
+    bool add(T&& e) {
+        emplace(std::move(e));
+        return  true;
+    }
+    
+    /**
+     *  Constructs an element from args at the end of this list and returns it.
+     */
+    template<class... Args>
+    T& emplace(Args&&... args) {
+        if(iSize < iCapacity) new(iStorage + iSize) T(std::forward<Args>(args)...);
+        else growAndEmplace(std::forward<Args>(args)...);
+        return iStorage[iSize++];
+    }
+    
     /**
      *  Inserts the specified element to the specified position in this list.
      * The range of index parameter is [0, size], where index=0 means inserting to the head,
@@ -133,17 +508,113 @@ public:
      */
     void add(int index, const T& element) {
         if(index < 0 || index > iSize) throw IndexOutOfBound();
-        autoSpace();
-        for(int i=iSize;i>index;--i)
-            iStorage[i] = iStorage[i-1];
-        iStorage[index] = element;
-        ++iSize;
+        add(index, T(element));
+    }
+    
+    /**
+     *  Inserts the specified element to the specified position in this list, moving it in.
+     * @throw IndexOutOfBound
+     */
+    void add(int index, T&& element) {
+        if(index < 0 || index > iSize) throw IndexOutOfBound();
+        if(index == iSize){
+            emplace(std::move(element));
+            return;
+        }
+        if(iTrivial){
+            T tmp(element);
+            if(iSize == iCapacity) reallocate(grownCapacity());
+            shift(iStorage + index + 1, iStorage + index, iSize - index);
+            new(iStorage + index) T(tmp);
+            ++iSize;
+            return;
+        }
+        emplace(std::move(iStorage[iSize - 1]));
+        for(int i=iSize-2;i>index;--i)
+            iStorage[i] = std::move(iStorage[i-1]);
+        iStorage[index] = std::move(element);
+    }
+    
+    /**
+     *  Appends the elements of [begin, end) in order, reallocating at most once.
+     * The range must not point into this list.
+     */
+    template<class Iter>
+    void addAll(Iter begin, Iter end) {
+        ensureCapacity(iSize + static_cast<int>(std::distance(begin, end)));
+        for(; begin != end; ++begin){
+            new(iStorage + iSize) T(*begin);
+            ++iSize;
+        }
+    }
+    
+    /**
+     *  Appends all of the elements of x in order, reallocating at most once.
+     * x may be this list.
+     */
+    void addAll(const ArrayList& x) {
+        int n = x.iSize;
+        ensureCapacity(iSize + n);
+        if(iTrivial){
+            shift(iStorage + iSize, x.iStorage, n);
+            iSize += n;
+            return;
+        }
+        for(int i=0; i<n; ++i){
+            new(iStorage + iSize) T(x.iStorage[i]);
+            ++iSize;
+        }
+    }
+    
+    /**
+     *  Inserts the elements of [begin, end) at the specified position, keeping
+     * their order. The tail is shifted once. The range must not point into
+     * this list.
+     * @throw IndexOutOfBound
+     */
+    template<class Iter>
+    void insertRange(int index, Iter begin, Iter end) {
+        if(index < 0 || index > iSize) throw IndexOutOfBound();
+        int n = static_cast<int>(std::distance(begin, end));
+        ensureCapacity(iSize + n);
+        if(iTrivial){
+            shift(iStorage + index + n, iStorage + index, iSize - index);
+            for(int i=index; begin != end; ++begin, ++i) new(iStorage + i) T(*begin);
+            iSize += n;
+            return;
+        }
+        int oldSize = iSize;
+        try{
+            for(; begin != end; ++begin){
+                new(iStorage + iSize) T(*begin);
+                ++iSize;
+            }
+        }
+        catch(...){
+            destroy(iStorage + oldSize, iSize - oldSize);
+            iSize = oldSize;
+            throw;
+        }
+        std::rotate(iStorage + index, iStorage + oldSize, iStorage + iSize);
+    }
+    
+    /**
+     *  Inserts all of the elements of x at the specified position. x may be this list.
+     * @throw IndexOutOfBound
+     */
+    void insertRange(int index, const ArrayList& x) {
+        if(&x == this){
+            ArrayList tmp(x);
+            insertRange(index, tmp.iStorage, tmp.iStorage + tmp.iSize);
+        }
+        else insertRange(index, x.iStorage, x.iStorage + x.iSize);
     }
     
     /**
-     *  Removes all of the elements from this list.
+     *  Removes all of the elements from this list. The capacity is kept.
      */
     void clear() {
+        destroy(iStorage, iSize);
         iSize = 0;
     }
     
@@ -151,10 +622,55 @@ public:
      *  Returns true if this list contains the specified element.
      */
     bool contains(const T& e) const {
-        for(int i=0; i<iSize; ++i)
-            if(iStorage[i] == e)
-                return true;
-        return false;
+        return indexOf(e) >= 0;
+    }
+    
+    /**
+     *  Returns the index of the first occurrence of the specified element, or -1.
+     */
+    int indexOf(const T& e) const {
+        return indexOf(e, Vectorized());
+    }
+    
+    /**
+     *  Returns the index of the last occurrence of the specified element, or -1.
+     */
+    int lastIndexOf(const T& e) const {
+        return lastIndexOf(e, Vectorized());
+    }
+    
+    /**
+     *  Returns the number of elements equal to the specified element.
+     */
+    int count(const T& e) const {
+        return count(e, Vectorized());
+    }
+    
+    /**
+     *  Returns the least element by operator<.
+     * @throw ElementNotExist if this list is empty
+     */
+    T min() const {
+        if(iSize == 0) throw ElementNotExist();
+        return extreme<false>(Vectorized());
+    }
+    
+    /**
+     *  Returns the greatest element by operator<.
+     * @throw ElementNotExist if this list is empty
+     */
+    T max() const {
+        if(iSize == 0) throw ElementNotExist();
+        return extreme<true>(Vectorized());
+    }
+    
+    /**
+     *  Returns the sum of the elements, or zero if this list is empty. Integers
+     * are summed in 64 bits and floating point values in double, in an order
+     * that may round differently from a left-to-right sum.
+     */
+    typename SumOf<T>::Type sum() const {
+        return sum(Vectorized());
     }
     
     /**
@@ -167,6 +683,25 @@ public:
         return iStorage[index];
     }
     
+    /**
+     *  Copies the element at the specified position into element and returns true,
+     * or returns false and leaves element untouched if the index is out of range.
+     */
+    bool tryGet(int index, T& element) const {
+        if(index < 0 || index >= iSize) return false;
+        element = iStorage[index];
+        return true;
+    }
+    
+    /**
+     *  Returns the element at the specified position, or defaultValue if the
+     * index is out of range.
+     */
+    T getOrDefault(int index, const T& defaultValue) const {
+        if(index < 0 || index >= iSize) return defaultValue;
+        return iStorage[index];
+    }
+    
     /**
      *  Returns true if this list contains no elements.
      */
@@ -181,9 +716,61 @@ public:
      */
     void removeIndex(int index) {
         if(index < 0 || index >= iSize) throw IndexOutOfBound();
+        if(iTrivial){
+            shift(iStorage + index, iStorage + index + 1, --iSize - index);
+            return;
+        }
         for (int i=index;i<iSize-1;++i)
-            iStorage[i] = iStorage[i+1];
-        --iSize;
+            iStorage[i] = std::move(iStorage[i+1]);
+        iStorage[--iSize].~T();
+    }
+    
+    /**
+     *  Removes the elements at positions [from, to), shifting the tail once.
+     * @throw IndexOutOfBound
+     */
+    void removeRange(int from, int to) {
+        if(from < 0 || from > to || to > iSize) throw IndexOutOfBound();
+        if(from == to) return;
+        if(iTrivial) shift(iStorage + from, iStorage + to, iSize - to);
+        else {
+            std::move(iStorage + to, iStorage + iSize, iStorage + from);
+            destroy(iStorage + iSize - (to - from), to - from);
+        }
+        iSize -= to - from;
+    }
+    
+    /**
+     *  Removes every element for which pred returns true, in a single pass.
+     * Returns the number of elements removed.
+     */
+    template<class F>
+    int removeIf(F pred) {
+        return filter(pred, false);
+    }
+    
+    /**
+     *  Removes every element that x contains, in a single pass.
+     * Returns the number of elements removed.
+     */
+    int removeAll(const ArrayList& x) {
+        if(&x == this){
+            int removed = iSize;
+            clear();
+            return removed;
+        }
+        ContainedIn pred(x);
+        return filter(pred, false);
+    }
+    
+    /**
+     *  Keeps only the elements that x contains, in a single pass.
+     * Returns the number of elements removed.
+     */
+    int retainAll(const ArrayList& x) {
+        if(&x == this) return 0;
+        ContainedIn pred(x);
+        return filter(pred, true);
     }
     
     /**
@@ -191,12 +778,10 @@ public:
      * Returns true if it was present in the list, otherwise false.
      */
     bool remove(const T &e) {
-        for(int p=0; p<iSize; ++p)
-            if(iStorage[p] == e){
-                removeIndex(p);
-                return true;
-            }
-        return false;
+        int p = indexOf(e);
+        if(p < 0) return false;
+        removeIndex(p);
+        return true;
     }
     
     /**
@@ -209,6 +794,15 @@ public:
         iStorage[index] = element;
     }
     
+    /**
+     *  Replaces the element at the specified position in this list, moving the new one in.
+     * @throw IndexOutOfBound
+     */
+    void set(int index, T &&element) {
+        if(index < 0 || index >= iSize) throw IndexOutOfBound();
+        iStorage[index] = std::move(element);
+    }
+    
     /**
      *  Returns the number of elements in this list.
      */
@@ -216,6 +810,127 @@ public:
         return iSize;
     }
     
+    /**
+     *  Returns the number of elements this list can hold before it reallocates.
+     */
+    int capacity() const {
+        return iCapacity;
+    }
+    
+    /**
+     *  Makes room for at least n elements, so that adding up to n elements
+     * does not reallocate.
+     */
+    void reserve(int n) {
+        if(n > iCapacity) reallocate(n);
+    }
+    
+    /**
+     *  Releases the unused capacity.
+     */
+    void shrinkToFit() {
+        if(iSize < iCapacity) reallocate(iSize);
+    }
+    
+    /**
+     *  Sets the factor the capacity is multiplied by when the list is full.
+     * Factors close to 1 waste less memory but copy more often.
+     * @throw IllegalArgument unless factor is finite and greater than 1
+     */
+    void setGrowthFactor(double factor) {
+        if(!std::isfinite(factor) || factor <= 1) throw IllegalArgument("growth factor must be finite and greater than 1");
+        iGrowthFactor = factor;
+    }
+    
+    /**
+     *  Sorts this list into ascending order by operator<. The order of equal
+     * elements is unspecified.
+     */
+    void sort() {
+        sort(std::less<T>());
+    }
+    
+    /**
+     *  Sorts this list so that cmp(get(j), get(i)) is false for every i < j.
+     * The order of equal elements is unspecified.
+     */
+    template<class Compare>
+    void sort(Compare cmp) {
+        std::sort(iStorage, iStorage + iSize, cmp);
+    }
+    
+    /**
+     *  Sorts this list into ascending order by operator<, keeping equal
+     * elements in their current order.
+     */
+    void stableSort() {
+        stableSort(std::less<T>());
+    }
+    
+    /**
+     *  Sorts this list by cmp, keeping equal elements in their current order.
+     */
+    template<class Compare>
+    void stableSort(Compare cmp) {
+        std::stable_sort(iStorage, iStorage + iSize, cmp);
+    }
+    
+    /**
+     *  Sorts this list into ascending order by operator< with up to threads
+     * threads, or one per core if threads <= 0. Integral types are radix
+     * sorted, which needs a second array of size() elements; other types
+     * are merge sorted. Either way the sort is stable.
+     */
+    void parallelSort(int threads = 0) {
+        parallelSort(threadsOrCores(threads), std::integral_constant<bool, ParallelSort<T>::radix>());
+    }
+    
+    /**
+     *  Stable merge sort by cmp with up to threads threads, or one per core
+     * if threads <= 0. cmp is called from several threads at once and must
+     * not throw.
+     */
+    template<class Compare>
+    void parallelSort(Compare cmp, int threads = 0) {
+        ParallelSort<T>::mergeSort(iStorage, iSize, cmp, threadsOrCores(threads));
+    }
+    
+    /**
+     *  Searches this list, which must be sorted by operator<, for the specified
+     * element. Returns the index of an equal element if there is one, and
+     * otherwise -(insertion point) - 1, where the insertion point is lowerBound(e).
+     */
+    int binarySearch(const T& e) const {
+        return binarySearch(e, std::less<T>());
+    }
+    
+    /**
+     *  Like binarySearch(e), for a list sorted by cmp.
+     */
+    template<class Compare>
+    int binarySearch(const T& e, Compare cmp) const {
+        int p = lowerBound(e, cmp);
+        if(p < iSize && !cmp(e, iStorage[p])) return p;
+        return -p - 1;
+    }
+    
+    /**
+     *  Returns the index of the first element not less than the specified
+     * element in this list, which must be sorted by operator<, or size() if
+     * there is none.
+     */
+    int lowerBound(const T& e) const {
+        return lowerBound(e, std::less<T>());
+    }
+    
+    /**
+     *  Like lowerBound(e), for a list sorted by cmp.
+     */
+    template<class Compare>
+    int lowerBound(const T& e, Compare cmp) const {
+        return static_cast<int>(std::lower_bound(iStorage, iStorage + iSize, e, cmp) - iStorage);
+    }
+    
     /**
      *  Returns an iterator over the elements in this list.
      */
@@ -224,4 +939,10 @@ public:
     }
 };
 
+/**
+ * An ArrayList that keeps up to N elements without touching the heap.
+ */
+template<class T, int N>
+using SmallArrayList = ArrayList<T, N>;
+
 #endif
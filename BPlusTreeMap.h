@@ -0,0 +1,889 @@
+/** @file */
+#ifndef __BPLUSTREEMAP_H
+#define __BPLUSTREEMAP_H
+
+#include <utility>
+
+#include "ElementNotExist.h"
+#include "ArrayList.h"
+
+/**
+ * BPlusTreeMap is a B+-tree for ordered maps too large for one heap node
+ * per key. Every node keeps its keys in a sorted array sized to span a few
+ * cache lines, so a lookup takes one dependent miss per level instead of
+ * one per comparison, and the depth is deterministic. Within a node the
+ * position of a key is found with a branch-free counting scan which
+ * compilers vectorize for arithmetic keys.
+ *
+ * Values live in the leaves only, next to (not interleaved with) the keys,
+ * and the leaves are linked in key order so that iteration and range scans
+ * read memory sequentially. fromSorted builds a packed tree in O(n).
+ *
+ * Because entries shift inside a node when neighbours are inserted or
+ * removed, iterators and find return entries by value and references
+ * returned by get are only valid until the next put or remove.
+ *
+ * It has the core interface of TreeMap: copying and moving, iterator,
+ * descendingIterator, clear, containsKey, containsValue, get, find,
+ * tryGet, getOrDefault, isEmpty, put, putIfAbsent, computeIfAbsent,
+ * remove, size, the floor, ceiling, higher, lower, first and last entries,
+ * pollFirst and pollLast, plus fromSorted. Entries are views rather than
+ * pointers, and pollFirst and pollLast return a SimpleEntry copy. Rank,
+ * select, countRange, aggregate, subMap views, splitAt, the set operations
+ * and Iterator::remove are TreeMap only.
+ */
+template<class K, class V>
+class BPlusTreeMap
+{
+public:
+    /**
+     * A view of one mapping, valid until the map is next modified. The
+     * entry find returns for a missing key is empty; an Entry tests and
+     * dereferences like the entry pointer the other maps return.
+     */
+    class Entry
+    {
+        const K *key;
+        const V *value;
+    public:
+        Entry(const K& k, const V& v)
+        :key(&k),value(&v){}
+        Entry()
+        :key(NULL),value(NULL){}
+
+        explicit operator bool() const
+        {
+            return key != NULL;
+        }
+
+        const Entry *operator->() const
+        {
+            return this;
+        }
+
+        const K& getKey() const
+        {
+            return *key;
+        }
+
+        const V& getValue() const
+        {
+            return *value;
+        }
+    };
+
+    /**
+     * A copy of one mapping, as pollFirst and pollLast return it.
+     */
+    class SimpleEntry
+    {
+        K key;
+        V value;
+    public:
+        SimpleEntry(const K& k, const V& v)
+        :key(k),value(v){}
+
+        const K& getKey() const
+        {
+            return key;
+        }
+
+        const V& getValue() const
+        {
+            return value;
+        }
+    };
+
+private:
+    static const int iKeysPerLine = 64 / sizeof(K) > 0 ? 64 / sizeof(K) : 1;
+    static const int iMaxKeys = iKeysPerLine * 8 < 8 ? 8 : (iKeysPerLine * 8 > 128 ? 128 : iKeysPerLine * 8);
+    static const int iMinKeys = iMaxKeys / 2;
+
+    struct Node{
+        bool leaf;
+        int n;
+        K keys[iMaxKeys];
+        Node(bool parLeaf):leaf(parLeaf),n(0){}
+    };
+
+    struct Inner : Node{
+        Node *child[iMaxKeys + 1];
+        Inner():Node(false){}
+    };
+
+    struct Leaf : Node{
+        V values[iMaxKeys];
+        Leaf *prev;
+        Leaf *next;
+        Leaf():Node(true),prev(NULL),next(NULL){}
+    };
+
+    Node *root;
+    int iSize;
+
+    /**
+     * Where insert left key, and whether it had to add it.
+     */
+    struct Slot{
+        Leaf *leaf;
+        int pos;
+        bool inserted;
+    };
+
+    struct ValueMaker{
+        const V& value;
+        ValueMaker(const V& v):value(v){}
+        const V& operator()(const K&) const { return value; }
+    };
+
+    /**
+     * Number of keys of node less than key, i.e. the position of key in a leaf.
+     */
+    static int countLess(const Node *node, const K& key){
+        int cnt = 0;
+        for(int i=0; i<node->n; ++i) cnt += node->keys[i] < key;
+        return cnt;
+    }
+
+    /**
+     * Number of keys of node not greater than key, i.e. the child to descend into.
+     */
+    static int countNotGreater(const Node *node, const K& key){
+        int cnt = 0;
+        for(int i=0; i<node->n; ++i) cnt += !(key < node->keys[i]);
+        return cnt;
+    }
+
+    Leaf* findLeaf(const K& key) const{
+        Node *node = root;
+        if(node == NULL) return NULL;
+        while(!node->leaf) node = static_cast<Inner*>(node)->child[countNotGreater(node, key)];
+        return static_cast<Leaf*>(node);
+    }
+
+    Leaf* firstLeaf() const{
+        Node *node = root;
+        if(node == NULL) return NULL;
+        while(!node->leaf) node = static_cast<Inner*>(node)->child[0];
+        return static_cast<Leaf*>(node);
+    }
+
+    Leaf* lastLeaf() const{
+        Node *node = root;
+        if(node == NULL) return NULL;
+        while(!node->leaf) node = static_cast<Inner*>(node)->child[node->n];
+        return static_cast<Leaf*>(node);
+    }
+
+    /**
+     * The entry at pos of leaf, stepping to the last entry of the previous
+     * leaf when pos is -1 or the first of the next when pos is leaf->n.
+     * Only the root leaf may be empty, so one step is enough.
+     */
+    static Entry entryAt(const Leaf *leaf, int pos){
+        if(leaf == NULL) return Entry();
+        if(pos < 0){
+            leaf = leaf->prev;
+            if(leaf == NULL) return Entry();
+            pos = leaf->n - 1;
+        }
+        else if(pos >= leaf->n){
+            leaf = leaf->next;
+            if(leaf == NULL || leaf->n == 0) return Entry();
+            pos = 0;
+        }
+        return Entry(leaf->keys[pos], leaf->values[pos]);
+    }
+
+    /**
+     * Returns the slot of key in its leaf, or -1 with leaf set to NULL.
+     */
+    int lookup(const K& key, Leaf *&leaf) const{
+        leaf = findLeaf(key);
+        if(leaf == NULL) return -1;
+        int pos = countLess(leaf, key);
+        if(pos < leaf->n && !(key < leaf->keys[pos])) return pos;
+        leaf = NULL;
+        return -1;
+    }
+
+    static void removeTree(Node *node){
+        if(node == NULL) return;
+        if(node->leaf){
+            delete static_cast<Leaf*>(node);
+            return;
+        }
+        Inner *inner = static_cast<Inner*>(node);
+        for(int i=0; i<=inner->n; ++i) removeTree(inner->child[i]);
+        delete inner;
+    }
+
+    /**
+     * Finds key in the subtree of node, adding it with the value make(key)
+     * if it is absent, and records where it is in slot. make is called
+     * before anything moves, so it may throw, and the value is copied first
+     * since it may refer into this map. If node had to split, returns the
+     * new right sibling and sets separator to its least key.
+     */
+    template<class F>
+    Node* insert(Node *node, const K& key, F& make, Slot& slot, K& separator){
+        if(node->leaf){
+            Leaf *leaf = static_cast<Leaf*>(node);
+            int pos = countLess(leaf, key);
+            if(pos < leaf->n && !(key < leaf->keys[pos])){
+                slot.leaf = leaf;
+                slot.pos = pos;
+                slot.inserted = false;
+                return NULL;
+            }
+            V value = make(key);
+            ++iSize;
+            slot.inserted = true;
+            if(leaf->n < iMaxKeys){
+                insertAt(leaf, pos, key, value);
+                slot.leaf = leaf;
+                slot.pos = pos;
+                return NULL;
+            }
+            Leaf *right = new Leaf;
+            int half = (iMaxKeys + 1) / 2;
+            for(int i=half; i<leaf->n; ++i){
+                right->keys[i - half] = leaf->keys[i];
+                right->values[i - half] = leaf->values[i];
+            }
+            right->n = leaf->n - half;
+            leaf->n = half;
+            right->next = leaf->next;
+            if(right->next != NULL) right->next->prev = right;
+            right->prev = leaf;
+            leaf->next = right;
+            if(pos <= half){
+                insertAt(leaf, pos, key, value);
+                slot.leaf = leaf;
+                slot.pos = pos;
+            }
+            else {
+                insertAt(right, pos - half, key, value);
+                slot.leaf = right;
+                slot.pos = pos - half;
+            }
+            separator = right->keys[0];
+            return right;
+        }
+        Inner *inner = static_cast<Inner*>(node);
+        int pos = countNotGreater(inner, key);
+        K childSeparator;
+        Node *split = insert(inner->child[pos], key, make, slot, childSeparator);
+        if(split == NULL) return NULL;
+        if(inner->n < iMaxKeys){
+            insertAt(inner, pos, childSeparator, split);
+            return NULL;
+        }
+        Inner *right = new Inner;
+        int half = iMaxKeys / 2;
+        if(pos < half){
+            moveTail(inner, right, half);
+            separator = inner->keys[half - 1];
+            inner->n = half - 1;
+            insertAt(inner, pos, childSeparator, split);
+        }
+        else if(pos > half){
+            moveTail(inner, right, half + 1);
+            separator = inner->keys[half];
+            inner->n = half;
+            insertAt(right, pos - half - 1, childSeparator, split);
+        }
+        else {
+            moveTail(inner, right, half);
+            separator = childSeparator;
+            right->child[0] = split;
+            inner->n = half;
+        }
+        return right;
+    }
+
+    static void insertAt(Leaf *leaf, int pos, const K& key, const V& value){
+        for(int i=leaf->n; i>pos; --i){
+            leaf->keys[i] = leaf->keys[i - 1];
+            leaf->values[i] = leaf->values[i - 1];
+        }
+        leaf->keys[pos] = key;
+        leaf->values[pos] = value;
+        ++leaf->n;
+    }
+
+    /**
+     * Inserts key at pos with child as the subtree right of it.
+     */
+    static void insertAt(Inner *inner, int pos, const K& key, Node *child){
+        for(int i=inner->n; i>pos; --i){
+            inner->keys[i] = inner->keys[i - 1];
+            inner->child[i + 1] = inner->child[i];
+        }
+        inner->keys[pos] = key;
+        inner->child[pos + 1] = child;
+        ++inner->n;
+    }
+
+    /**
+     * Moves keys [from, n) and the children from from on into the empty node right.
+     */
+    static void moveTail(Inner *inner, Inner *right, int from){
+        right->n = inner->n - from;
+        right->child[0] = inner->child[from];
+        for(int i=from; i<inner->n; ++i){
+            right->keys[i - from] = inner->keys[i];
+            right->child[i - from + 1] = inner->child[i + 1];
+        }
+    }
+
+    /**
+     * Removes key from the subtree of node and returns true if it was there.
+     * Children left with fewer than iMinKeys keys are refilled on the way up.
+     */
+    bool remove(Node *node, const K& key){
+        if(node->leaf){
+            Leaf *leaf = static_cast<Leaf*>(node);
+            int pos = countLess(leaf, key);
+            if(pos >= leaf->n || key < leaf->keys[pos]) return false;
+            for(int i=pos; i<leaf->n - 1; ++i){
+                leaf->keys[i] = leaf->keys[i + 1];
+                leaf->values[i] = leaf->values[i + 1];
+            }
+            --leaf->n;
+            --iSize;
+            return true;
+        }
+        Inner *inner = static_cast<Inner*>(node);
+        int pos = countNotGreater(inner, key);
+        if(!remove(inner->child[pos], key)) return false;
+        if(inner->child[pos]->n < iMinKeys) rebalance(inner, pos);
+        return true;
+    }
+
+    /**
+     * Refills the underfull child pos of inner by borrowing one key from a
+     * sibling, or merges it with a sibling when both are at the minimum.
+     */
+    static void rebalance(Inner *inner, int pos){
+        if(pos > 0 && inner->child[pos - 1]->n > iMinKeys) borrowFromLeft(inner, pos);
+        else if(pos < inner->n && inner->child[pos + 1]->n > iMinKeys) borrowFromRight(inner, pos);
+        else if(pos > 0) merge(inner, pos - 1);
+        else if(pos < inner->n) merge(inner, pos);
+    }
+
+    static void borrowFromLeft(Inner *inner, int pos){
+        Node *node = inner->child[pos], *left = inner->child[pos - 1];
+        for(int i=node->n; i>0; --i) node->keys[i] = node->keys[i - 1];
+        if(node->leaf){
+            Leaf *leaf = static_cast<Leaf*>(node), *from = static_cast<Leaf*>(left);
+            for(int i=leaf->n; i>0; --i) leaf->values[i] = leaf->values[i - 1];
+            leaf->keys[0] = from->keys[from->n - 1];
+            leaf->values[0] = from->values[from->n - 1];
+            inner->keys[pos - 1] = leaf->keys[0];
+        }
+        else {
+            Inner *to = static_cast<Inner*>(node), *from = static_cast<Inner*>(left);
+            for(int i=to->n + 1; i>0; --i) to->child[i] = to->child[i - 1];
+            to->keys[0] = inner->keys[pos - 1];
+            to->child[0] = from->child[from->n];
+            inner->keys[pos - 1] = from->keys[from->n - 1];
+        }
+        ++node->n;
+        --left->n;
+    }
+
+    static void borrowFromRight(Inner *inner, int pos){
+        Node *node = inner->child[pos], *right = inner->child[pos + 1];
+        if(node->leaf){
+            Leaf *leaf = static_cast<Leaf*>(node), *from = static_cast<Leaf*>(right);
+            leaf->keys[leaf->n] = from->keys[0];
+            leaf->values[leaf->n] = from->values[0];
+            for(int i=0; i<from->n - 1; ++i){
+                from->keys[i] = from->keys[i + 1];
+                from->values[i] = from->values[i + 1];
+            }
+            inner->keys[pos] = from->keys[0];
+        }
+        else {
+            Inner *to = static_cast<Inner*>(node), *from = static_cast<Inner*>(right);
+            to->keys[to->n] = inner->keys[pos];
+            to->child[to->n + 1] = from->child[0];
+            inner->keys[pos] = from->keys[0];
+            for(int i=0; i<from->n - 1; ++i) from->keys[i] = from->keys[i + 1];
+            for(int i=0; i<from->n; ++i) from->child[i] = from->child[i + 1];
+        }
+        ++node->n;
+        --right->n;
+    }
+
+    /**
+     * Merges child pos + 1 of inner into child pos and drops the separator between them.
+     */
+    static void merge(Inner *inner, int pos){
+        Node *node = inner->child[pos], *right = inner->child[pos + 1];
+        if(node->leaf){
+            Leaf *leaf = static_cast<Leaf*>(node), *from = static_cast<Leaf*>(right);
+            for(int i=0; i<from->n; ++i){
+                leaf->keys[leaf->n + i] = from->keys[i];
+                leaf->values[leaf->n + i] = from->values[i];
+            }
+            leaf->n += from->n;
+            leaf->next = from->next;
+            if(leaf->next != NULL) leaf->next->prev = leaf;
+            delete from;
+        }
+        else {
+            Inner *to = static_cast<Inner*>(node), *from = static_cast<Inner*>(right);
+            to->keys[to->n] = inner->keys[pos];
+            for(int i=0; i<from->n; ++i) to->keys[to->n + 1 + i] = from->keys[i];
+            for(int i=0; i<=from->n; ++i) to->child[to->n + 1 + i] = from->child[i];
+            to->n += from->n + 1;
+            delete from;
+        }
+        for(int i=pos; i<inner->n - 1; ++i){
+            inner->keys[i] = inner->keys[i + 1];
+            inner->child[i + 1] = inner->child[i + 2];
+        }
+        --inner->n;
+    }
+
+    /**
+     * Finds key, adding it with the value make(key) if it is absent, in one
+     * descent.
+     */
+    template<class F>
+    Slot locate(const K& key, F& make){
+        if(root == NULL) root = new Leaf;
+        Slot slot;
+        K separator;
+        Node *split = insert(root, key, make, slot, separator);
+        if(split != NULL){
+            Inner *top = new Inner;
+            top->n = 1;
+            top->keys[0] = separator;
+            top->child[0] = root;
+            top->child[1] = split;
+            root = top;
+        }
+        return slot;
+    }
+
+    template<class E>
+    static void assign(const E& entry, K& key, V& value){
+        key = entry.getKey();
+        value = entry.getValue();
+    }
+
+    /**
+     * Number of nodes to pack m items into when each holds at most cap.
+     */
+    static int groups(int m, int cap){
+        return (m + cap - 1) / cap;
+    }
+
+public:
+    /**
+     * Iterates in ascending key order, or in descending order when obtained
+     * through descendingIterator().
+     */
+    class Iterator
+    {
+    private:
+        const Leaf *pLeaf;
+        int iPos;
+        bool descending;
+
+        void skipEmpty(){
+            if(pLeaf == NULL) return;
+            if(descending && iPos < 0){
+                pLeaf = pLeaf->prev;
+                if(pLeaf != NULL) iPos = pLeaf->n - 1;
+            }
+            else if(!descending && iPos >= pLeaf->n){
+                pLeaf = pLeaf->next;
+                iPos = 0;
+            }
+        }
+    public:
+        Iterator(const Leaf *parLeaf, int parPos, bool parDescending = false)
+        :pLeaf(parLeaf),iPos(parPos),descending(parDescending){
+            skipEmpty();
+        }
+        /**
+         * Returns true if the iteration has more elements.
+         */
+        bool hasNext() {
+            return pLeaf != NULL;
+        }
+
+        /**
+         * Returns the next element in the iteration.
+         * @throw ElementNotExist exception when hasNext() == false
+         */
+        Entry next() {
+            if(!hasNext()) throw ElementNotExist();
+            Entry tmp(pLeaf->keys[iPos], pLeaf->values[iPos]);
+            if(descending) --iPos;
+            else ++iPos;
+            skipEmpty();
+            return tmp;
+        }
+    };
+
+    /**
+     * Constructs an empty map.
+     */
+    BPlusTreeMap()
+    :root(NULL),iSize(0){}
+
+    /**
+     * Destructor
+     */
+    ~BPlusTreeMap() {
+        removeTree(root);
+    }
+
+    /**
+     * Assignment operator
+     */
+    BPlusTreeMap &operator=(const BPlusTreeMap &x) {
+        if(this == &x) return *this;
+        clear();
+        Iterator itr = x.iterator();
+        load(itr, x.iSize);
+        return *this;
+    }
+
+    /**
+     * Copy-constructor
+     */
+    BPlusTreeMap(const BPlusTreeMap &x)
+    :root(NULL),iSize(0) {
+        Iterator itr = x.iterator();
+        load(itr, x.iSize);
+    }
+
+    /**
+     * Move-constructor. x is left empty.
+     */
+    BPlusTreeMap(BPlusTreeMap &&x)
+    :root(x.root),iSize(x.iSize) {
+        x.root = NULL;
+        x.iSize = 0;
+    }
+
+    /**
+     * Move assignment operator. x is left empty.
+     */
+    BPlusTreeMap &operator=(BPlusTreeMap &&x) {
+        if(this == &x) return *this;
+        clear();
+        std::swap(root, x.root);
+        std::swap(iSize, x.iSize);
+        return *this;
+    }
+
+    /**
+     * Replaces the contents of this empty map with the n entries produced by
+     * itr, whose keys must be strictly ascending. Leaves and inner nodes are
+     * packed full, apart from evening out the last ones, in O(n).
+     */
+    template<class Iter>
+    void load(Iter &itr, int n) {
+        if(n == 0) return;
+        ArrayList<Node*> level;
+        ArrayList<K> lows;
+        Leaf *last = NULL;
+        for(int g = groups(n, iMaxKeys), i = 0; i < g; ++i){
+            Leaf *leaf = new Leaf;
+            leaf->n = n / g + (i < n % g ? 1 : 0);
+            for(int j=0; j<leaf->n; ++j) assign(itr.next(), leaf->keys[j], leaf->values[j]);
+            leaf->prev = last;
+            if(last != NULL) last->next = leaf;
+            last = leaf;
+            level.add(leaf);
+            lows.add(leaf->keys[0]);
+        }
+        while(level.size() > 1){
+            ArrayList<Node*> upper;
+            ArrayList<K> upperLows;
+            int m = level.size();
+            for(int g = groups(m, iMaxKeys + 1), i = 0, next = 0; i < g; ++i){
+                Inner *inner = new Inner;
+                int cnt = m / g + (i < m % g ? 1 : 0);
+                for(int j=0; j<cnt; ++j){
+                    inner->child[j] = level.get(next + j);
+                    if(j > 0) inner->keys[j - 1] = lows.get(next + j);
+                }
+                inner->n = cnt - 1;
+                upper.add(inner);
+                upperLows.add(lows.get(next));
+                next += cnt;
+            }
+            level = upper;
+            lows = upperLows;
+        }
+        root = level.get(0);
+        iSize = n;
+    }
+
+    /**
+     * Builds a map from the entries in [begin, end) in O(n). Each element
+     * must provide getKey() and getValue(), like Entry does, and the keys
+     * should be ascending; of equal neighbouring keys the last one wins.
+     * Elements that break the order are still accepted but cost a put each.
+     */
+    template<class It>
+    static BPlusTreeMap fromSorted(It begin, It end) {
+        int n = 0;
+        It stop = begin;
+        for(It last = begin; stop != end; last = stop++){
+            if(stop != begin && !(last->getKey() < stop->getKey())){
+                if(stop->getKey() < last->getKey()) break;
+                continue;
+            }
+            ++n;
+        }
+        struct Range{
+            It pos;
+            It stop;
+            auto next() -> decltype(*pos) {
+                It tmp = pos;
+                while(++pos != stop && !(tmp->getKey() < pos->getKey())) tmp = pos;
+                return *tmp;
+            }
+        } itr = { begin, stop };
+        BPlusTreeMap result;
+        result.load(itr, n);
+        for(; stop != end; ++stop) result.put(stop->getKey(), stop->getValue());
+        return result;
+    }
+
+    /**
+     * Returns an iterator over the elements in this map.
+     */
+    Iterator iterator() const {
+        return Iterator(firstLeaf(), 0);
+    }
+
+    /**
+     * Returns an iterator over the elements in this map in descending key order.
+     */
+    Iterator descendingIterator() const {
+        Leaf *leaf = lastLeaf();
+        return Iterator(leaf, leaf == NULL ? 0 : leaf->n - 1, true);
+    }
+
+    /**
+     * Returns an iterator starting at the least key not less than key.
+     * It walks the linked leaves, so scanning a range is sequential.
+     */
+    Iterator iteratorFrom(const K &key) const {
+        Leaf *leaf = findLeaf(key);
+        return Iterator(leaf, leaf == NULL ? 0 : countLess(leaf, key));
+    }
+
+    /**
+     * Removes all of the mappings from this map.
+     */
+    void clear() {
+        removeTree(root);
+        root = NULL;
+        iSize = 0;
+    }
+
+    /**
+     * Returns true if this map contains a mapping for the specified key.
+     */
+    bool containsKey(const K &key) const {
+        Leaf *leaf;
+        return lookup(key, leaf) >= 0;
+    }
+
+    /**
+     * Returns true if this map maps one or more keys to the specified value.
+     */
+    bool containsValue(const V &value) const {
+        for(const Leaf *leaf = firstLeaf(); leaf != NULL; leaf = leaf->next)
+            for(int i=0; i<leaf->n; ++i)
+                if(leaf->values[i] == value) return true;
+        return false;
+    }
+
+    /**
+     * Returns a const reference to the value to which the specified key is mapped.
+     * @throw ElementNotExist
+     */
+    const V &get(const K &key) const {
+        Leaf *leaf;
+        int pos = lookup(key, leaf);
+        if(pos < 0) throw ElementNotExist();
+        return leaf->values[pos];
+    }
+
+    /**
+     * Returns the entry mapped to key, or an empty Entry if the key is not
+     * present. Unlike get, a miss does not throw.
+     */
+    Entry find(const K &key) const {
+        Leaf *leaf;
+        int pos = lookup(key, leaf);
+        return pos < 0 ? Entry() : Entry(leaf->keys[pos], leaf->values[pos]);
+    }
+
+    /**
+     * Copies the value mapped to key into value and returns true, or
+     * returns false and leaves value untouched if the key is not present.
+     */
+    bool tryGet(const K &key, V &value) const {
+        Entry tmp = find(key);
+        if(!tmp) return false;
+        value = tmp->getValue();
+        return true;
+    }
+
+    /**
+     * Returns the value mapped to key, or defaultValue if the key is not present.
+     */
+    V getOrDefault(const K &key, const V &defaultValue) const {
+        Entry tmp = find(key);
+        return tmp ? tmp->getValue() : defaultValue;
+    }
+
+    /**
+     * Returns true if this map contains no key-value mappings.
+     */
+    bool isEmpty() const {
+        return !iSize;
+    }
+
+    /**
+     * Associates the specified value with the specified key in this map.
+     */
+    void put(const K &key, const V &value) {
+        ValueMaker make(value);
+        Slot slot = locate(key, make);
+        if(!slot.inserted) slot.leaf->values[slot.pos] = value;
+    }
+
+    /**
+     * Associates the specified value with the specified key only if the key
+     * is not already mapped. Returns true if the value was put.
+     */
+    bool putIfAbsent(const K &key, const V &value) {
+        ValueMaker make(value);
+        return locate(key, make).inserted;
+    }
+
+    /**
+     * Returns the value mapped to key, first mapping it to fn(key) if the
+     * key is absent. fn is only called when the key is absent.
+     */
+    template<class F>
+    const V &computeIfAbsent(const K &key, F fn) {
+        Slot slot = locate(key, fn);
+        return slot.leaf->values[slot.pos];
+    }
+
+    /**
+     * Removes the mapping for the specified key from this map.
+     * @throw ElementNotExist
+     */
+    void remove(const K &key) {
+        if(root == NULL || !remove(root, key)) throw ElementNotExist();
+        if(!root->leaf && root->n == 0){
+            Inner *top = static_cast<Inner*>(root);
+            root = top->child[0];
+            delete top;
+        }
+        else if(root->leaf && root->n == 0){
+            delete static_cast<Leaf*>(root);
+            root = NULL;
+        }
+    }
+
+    /**
+     * Returns the number of key-value mappings in this map.
+     */
+    int size() const {
+        return iSize;
+    }
+
+    /**
+     * Returns the entry with the greatest key less than or equal to key,
+     * or an empty Entry if there is none.
+     */
+    Entry floorEntry(const K &key) const {
+        Leaf *leaf = findLeaf(key);
+        return entryAt(leaf, leaf == NULL ? 0 : countNotGreater(leaf, key) - 1);
+    }
+
+    /**
+     * Returns the entry with the least key greater than or equal to key,
+     * or an empty Entry if there is none.
+     */
+    Entry ceilingEntry(const K &key) const {
+        Leaf *leaf = findLeaf(key);
+        return entryAt(leaf, leaf == NULL ? 0 : countLess(leaf, key));
+    }
+
+    /**
+     * Returns the entry with the least key strictly greater than key,
+     * or an empty Entry if there is none.
+     */
+    Entry higherEntry(const K &key) const {
+        Leaf *leaf = findLeaf(key);
+        return entryAt(leaf, leaf == NULL ? 0 : countNotGreater(leaf, key));
+    }
+
+    /**
+     * Returns the entry with the greatest key strictly less than key,
+     * or an empty Entry if there is none.
+     */
+    Entry lowerEntry(const K &key) const {
+        Leaf *leaf = findLeaf(key);
+        return entryAt(leaf, leaf == NULL ? 0 : countLess(leaf, key) - 1);
+    }
+
+    /**
+     * Returns the entry with the least key, or an empty Entry if this map is empty.
+     */
+    Entry firstEntry() const {
+        return entryAt(firstLeaf(), 0);
+    }
+
+    /**
+     * Returns the entry with the greatest key, or an empty Entry if this map is empty.
+     */
+    Entry lastEntry() const {
+        Leaf *leaf = lastLeaf();
+        return entryAt(leaf, leaf == NULL ? 0 : leaf->n - 1);
+    }
+
+    /**
+     * Removes the entry with the least key and returns a copy of it.
+     * @throw ElementNotExist if this map is empty
+     */
+    SimpleEntry pollFirst() {
+        Entry tmp = firstEntry();
+        if(!tmp) throw ElementNotExist();
+        SimpleEntry result(tmp->getKey(), tmp->getValue());
+        remove(result.getKey());
+        return result;
+    }
+
+    /**
+     * Removes the entry with the greatest key and returns a copy of it.
+     * @throw ElementNotExist if this map is empty
+     */
+    SimpleEntry pollLast() {
+        Entry tmp = lastEntry();
+        if(!tmp) throw ElementNotExist();
+        SimpleEntry result(tmp->getKey(), tmp->getValue());
+        remove(result.getKey());
+        return result;
+    }
+};
+
+#endif
@@ -0,0 +1,275 @@
+/** @file */
+#ifndef __CONCURRENTARRAYLIST_H
+#define __CONCURRENTARRAYLIST_H
+#include <atomic>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "IndexOutOfBound.h"
+#include "ElementNotExist.h"
+
+/**
+ * ConcurrentArrayList is an append-only list that many threads may add to
+ * and read from at once without external locking.
+ *
+ * The elements live in buckets that are never moved or freed while the
+ * list exists: bucket b holds 32 << b elements, so element i is found with
+ * one bit scan, and a reference returned by get() stays valid. A writer
+ * allocates the bucket of the next free index if it is the first to need
+ * it, claims that index with a compare-and-swap, constructs the element and
+ * marks its slot ready. Every writer then moves the published prefix
+ * forward over the ready slots it finds, so a slow writer holds back size()
+ * without blocking anyone.
+ *
+ * Nothing can fail once an index is claimed: the element is built before
+ * the claim unless its constructor cannot throw, and is then moved into
+ * its slot, so T must be nothrow move constructible. An add that throws
+ * leaves the list as it was.
+ *
+ * get(i) and size() are wait-free and only ever see fully constructed
+ * elements: size() is the length of the published prefix, and get(i)
+ * throws for indexes beyond it. Iterators are weakly consistent: they walk
+ * the elements published so far and may or may not see later ones.
+ *
+ * Destroying the list must not race with any other use of it.
+ */
+template<class T>
+class ConcurrentArrayList
+{
+    static_assert(std::is_nothrow_move_constructible<T>::value, "ConcurrentArrayList needs a nothrow move constructible element type");
+
+private:
+    struct Slot{
+        std::atomic<bool> ready;
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type value;
+        Slot()
+        :ready(false){}
+        T *element() { return reinterpret_cast<T*>(&value); }
+    };
+
+    static const int iFirstShift = 5;
+    static const int iBuckets = 32 - iFirstShift;
+
+    std::atomic<Slot*> iBucket[iBuckets];
+    std::atomic<int> iClaimed;
+    std::atomic<int> iPublished;
+
+    static int bucketOf(int index){
+        return 31 - __builtin_clz(static_cast<unsigned>(index) + (1u << iFirstShift)) - iFirstShift;
+    }
+
+    static int offsetIn(int index, int bucket){
+        return static_cast<int>(static_cast<unsigned>(index) + (1u << iFirstShift) - (1u << (bucket + iFirstShift)));
+    }
+
+    /**
+     * The slot of index, or NULL if its bucket has not been allocated yet.
+     */
+    Slot* find(int index) const{
+        int bucket = bucketOf(index);
+        Slot *slots = iBucket[bucket].load(std::memory_order_acquire);
+        return slots == NULL ? NULL : slots + offsetIn(index, bucket);
+    }
+
+    /**
+     * Allocates the bucket of index if no other writer has.
+     * @throw std::bad_alloc
+     */
+    void reserve(int index){
+        int bucket = bucketOf(index);
+        Slot *slots = iBucket[bucket].load(std::memory_order_acquire);
+        if(slots != NULL) return;
+        Slot *tmp = new Slot[static_cast<size_t>(1) << (bucket + iFirstShift)];
+        if(!iBucket[bucket].compare_exchange_strong(slots, tmp, std::memory_order_acq_rel)) delete[] tmp;
+    }
+
+    /**
+     * Claims the next free index, whose bucket is allocated first, so that
+     * no index is ever claimed and then abandoned.
+     * @throw IndexOutOfBound if the list is full
+     * @throw std::bad_alloc
+     */
+    Slot* claim(int &index){
+        index = iClaimed.load(std::memory_order_relaxed);
+        do{
+            if(index > 0x7fffffff - (1 << iFirstShift)) throw IndexOutOfBound();
+            reserve(index);
+        }while(!iClaimed.compare_exchange_weak(index, index + 1, std::memory_order_acq_rel, std::memory_order_relaxed));
+        return find(index);
+    }
+
+    /**
+     * Moves the published prefix over every ready slot that follows it.
+     * The walk stops only at a slot whose ready flag reads false. Those
+     * flags are stored and loaded sequentially consistently, so of two
+     * writers finishing around the same time at least one sees the slot of
+     * the other as ready, and no slot is left behind.
+     */
+    void publish(){
+        int p = iPublished.load(std::memory_order_acquire);
+        for(;;){
+            Slot *slot = find(p);
+            if(slot == NULL || !slot->ready.load(std::memory_order_seq_cst)) return;
+            if(iPublished.compare_exchange_weak(p, p + 1, std::memory_order_acq_rel)) ++p;
+        }
+    }
+
+    template<class... Args>
+    int emplaceAt(std::true_type, Args&&... args){
+        int index;
+        Slot *slot = claim(index);
+        new(slot->element()) T(std::forward<Args>(args)...);
+        slot->ready.store(true, std::memory_order_seq_cst);
+        return index;
+    }
+
+    template<class... Args>
+    int emplaceAt(std::false_type, Args&&... args){
+        T tmp(std::forward<Args>(args)...);
+        return emplaceAt(std::true_type(), std::move(tmp));
+    }
+
+    void destroyAll(){
+        for(int bucket=0; bucket<iBuckets; ++bucket){
+            Slot *slots = iBucket[bucket].load(std::memory_order_relaxed);
+            if(slots == NULL) continue;
+            int n = 1 << (bucket + iFirstShift);
+            for(int i=0; i<n; ++i)
+                if(slots[i].ready.load(std::memory_order_relaxed)) slots[i].element()->~T();
+            delete[] slots;
+            iBucket[bucket].store(NULL, std::memory_order_relaxed);
+        }
+        iClaimed.store(0, std::memory_order_relaxed);
+        iPublished.store(0, std::memory_order_relaxed);
+    }
+
+public:
+    class Iterator
+    {
+    private:
+        int position;
+        const ConcurrentArrayList *pArray;
+    public:
+        Iterator(const ConcurrentArrayList *parArray)
+        :position(0),pArray(parArray){}
+        /**
+         * Returns true if the iteration has more elements published.
+         */
+        bool hasNext() {
+            return position < pArray->size();
+        }
+
+        /**
+         * Returns the next element in the iteration.
+         * @throw ElementNotExist exception when hasNext() == false
+         */
+        const T &next() {
+            if(!hasNext()) throw ElementNotExist();
+            return pArray->get(position++);
+        }
+    };
+
+    /**
+     *  Constructs an empty list. Buckets are allocated as they are needed.
+     */
+    ConcurrentArrayList()
+    :iClaimed(0),iPublished(0) {
+        for(int bucket=0; bucket<iBuckets; ++bucket) iBucket[bucket].store(NULL, std::memory_order_relaxed);
+    }
+
+    ConcurrentArrayList(const ConcurrentArrayList&) = delete;
+    ConcurrentArrayList& operator=(const ConcurrentArrayList&) = delete;
+
+    /**
+     *  Destructor
+     */
+    ~ConcurrentArrayList() {
+        destroyAll();
+    }
+
+    /**
+     *  Appends the specified element and returns its index. The element is
+     * part of size() once every element before it is published too.
+     * @throw IndexOutOfBound if the list is full, at 2^31 - 32 elements
+     */
+    int add(const T& e) {
+        return emplace(e);
+    }
+
+    /**
+     *  Appends the specified element, moving it in, and returns its index.
+     * @throw IndexOutOfBound if the list is full
+     */
+    int add(T&& e) {
+        return emplace(std::move(e));
+    }
+
+    /**
+     *  Constructs an element from args at the end of this list and returns
+     * its index. If the constructor throws, or memory runs out, nothing is
+     * claimed and the list is unchanged.
+     * @throw IndexOutOfBound if the list is full
+     */
+    template<class... Args>
+    int emplace(Args&&... args) {
+        int index = emplaceAt(std::integral_constant<bool, std::is_nothrow_constructible<T, Args&&...>::value>(), std::forward<Args>(args)...);
+        publish();
+        return index;
+    }
+
+    /**
+     *  Returns a const reference to the element at the specified position,
+     * which stays valid for the lifetime of the list.
+     * The index is zero-based, with range [0, size).
+     * @throw IndexOutOfBound
+     */
+    const T& get(int index) const {
+        if(index < 0 || index >= size()) throw IndexOutOfBound();
+        return *find(index)->element();
+    }
+
+    /**
+     *  Copies the element at the specified position into element and returns true,
+     * or returns false and leaves element untouched if it is not published.
+     */
+    bool tryGet(int index, T& element) const {
+        if(index < 0 || index >= size()) return false;
+        element = *find(index)->element();
+        return true;
+    }
+
+    /**
+     *  Returns true if this list contains the specified element among those published.
+     */
+    bool contains(const T& e) const {
+        for(int i=0, n=size(); i<n; ++i)
+            if(*find(i)->element() == e)
+                return true;
+        return false;
+    }
+
+    /**
+     *  Returns true if no element is published yet.
+     */
+    bool isEmpty() const {
+        return size() == 0;
+    }
+
+    /**
+     *  Returns the number of published elements: every element with a
+     * smaller index is fully constructed and visible to the caller.
+     */
+    int size() const {
+        return iPublished.load(std::memory_order_acquire);
+    }
+
+    /**
+     *  Returns an iterator over the published elements of this list.
+     */
+    Iterator iterator() const {
+        return Iterator(this);
+    }
+};
+
+#endif
@@ -0,0 +1,429 @@
+/** @file */
+#ifndef __CONCURRENTTREEMAP_H
+#define __CONCURRENTTREEMAP_H
+#include <atomic>
+#include <new>
+#include <thread>
+
+#include "ElementNotExist.h"
+#include "EpochManager.h"
+
+/**
+ * ConcurrentTreeMap is an ordered map that may be read and updated by many
+ * threads at once without external locking.
+ *
+ * It is a lazy skip list rather than a treap: a treap rotation rewrites
+ * links around the root, so every writer would contend on the top of the
+ * tree, while a skip list insert or remove only relinks the O(log n)
+ * predecessors of its own key. Lookups take no locks and never wait. A
+ * writer locks just those predecessors, checks that nothing changed under
+ * it, and retries otherwise; a removed node is first marked, so readers
+ * skip it, and then unlinked. Writers on distinct parts of the key space
+ * proceed in parallel.
+ *
+ * Removed nodes and replaced values are freed through EpochManager, once no
+ * reader can still hold them. Node heights come from a per-thread generator,
+ * so no shared random state is touched either.
+ *
+ * Values are returned by copy, since another thread may replace them at any
+ * time. Iterators walk the keys in the natural order (operator<) and are
+ * weakly consistent: they never fail, see every entry present for their
+ * whole lifetime, and may or may not see concurrent updates. A live
+ * iterator holds back memory reclamation, so it should not be kept longer
+ * than needed, and must be used on the thread that created it.
+ */
+template<class K, class V>
+class ConcurrentTreeMap
+{
+public:
+    class Entry
+    {
+        K key;
+        V value;
+    public:
+        Entry(const K& k, const V& v)
+        :key(k),value(v){}
+
+        const K& getKey() const
+        {
+            return key;
+        }
+
+        const V& getValue() const
+        {
+            return value;
+        }
+    };
+
+private:
+    /**
+     * Enough for 2^24 keys at the expected height; taller towers are capped.
+     */
+    static const int iMaxLevel = 24;
+
+    class SpinLock
+    {
+        std::atomic_flag flag;
+    public:
+        SpinLock(){
+            flag.clear();
+        }
+        void lock(){
+            while(flag.test_and_set(std::memory_order_acquire)) std::this_thread::yield();
+        }
+        void unlock(){
+            flag.clear(std::memory_order_release);
+        }
+    };
+
+    /**
+     * A tower of height topLevel; its links are allocated right after it.
+     */
+    struct Node{
+        K key;
+        std::atomic<V*> value;
+        int topLevel;
+        std::atomic<bool> marked;
+        std::atomic<bool> fullyLinked;
+        SpinLock lock;
+        std::atomic<Node*> *next;
+        Node(const K& parKey, V *parValue, int parLevel)
+        :key(parKey),value(parValue),topLevel(parLevel),marked(false),fullyLinked(false){
+            next = reinterpret_cast<std::atomic<Node*>*>(this + 1);
+            for(int i=0; i<topLevel; ++i) new(next + i) std::atomic<Node*>(NULL);
+        }
+    };
+
+    Node *pHead;
+    std::atomic<int> iSize;
+
+    static Node* createNode(const K& key, V *value, int level){
+        void *raw = ::operator new(sizeof(Node) + level * sizeof(std::atomic<Node*>));
+        return new(raw) Node(key, value, level);
+    }
+
+    static void destroyNode(void *p){
+        Node *tmp = static_cast<Node*>(p);
+        delete tmp->value.load(std::memory_order_relaxed);
+        tmp->~Node();
+        ::operator delete(p);
+    }
+
+    static void destroyValue(void *p){
+        delete static_cast<V*>(p);
+    }
+
+    /**
+     * Draws a height with P(h > k) = 2^-k from a xorshift generator private
+     * to the calling thread.
+     */
+    static int randomLevel(){
+        static thread_local unsigned long long seed = 0;
+        if(seed == 0) seed = (reinterpret_cast<unsigned long long>(&seed) | 1) * 0x9E3779B97F4A7C15ULL;
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        unsigned long long bits = seed >> 32;
+        int level = 1;
+        while((bits & 1) && level < iMaxLevel){
+            ++level;
+            bits >>= 1;
+        }
+        return level;
+    }
+
+    /**
+     * Fills preds and succs with the nodes around key on every level and
+     * returns the highest level where succs holds key, or -1.
+     * Must be called inside an EpochManager::Guard.
+     */
+    int find(const K& key, Node **preds, Node **succs) const{
+        int found = -1;
+        Node *pred = pHead;
+        for(int level = iMaxLevel - 1; level >= 0; --level){
+            Node *curr = pred->next[level].load(std::memory_order_acquire);
+            while(curr != NULL && curr->key < key){
+                pred = curr;
+                curr = pred->next[level].load(std::memory_order_acquire);
+            }
+            if(found == -1 && curr != NULL && !(key < curr->key)) found = level;
+            preds[level] = pred;
+            succs[level] = curr;
+        }
+        return found;
+    }
+
+    /**
+     * Returns the live node holding key, or NULL. Takes no locks.
+     * Must be called inside an EpochManager::Guard.
+     */
+    Node* lookup(const K& key) const{
+        Node *pred = pHead;
+        for(int level = iMaxLevel - 1; level >= 0; --level){
+            Node *curr = pred->next[level].load(std::memory_order_acquire);
+            while(curr != NULL && curr->key < key){
+                pred = curr;
+                curr = pred->next[level].load(std::memory_order_acquire);
+            }
+            if(curr != NULL && !(key < curr->key))
+                return curr->fullyLinked.load() && !curr->marked.load() ? curr : NULL;
+        }
+        return NULL;
+    }
+
+    /**
+     * Locks the distinct nodes of preds[0, levels) from the bottom up, which
+     * is descending key order, and checks that each still links to succs at
+     * its level and that neither is marked, apart from removing. Returns the
+     * number of levels locked; all of them when valid.
+     */
+    static int lockPreds(Node **preds, Node **succs, int levels, const Node *removing, bool &valid){
+        Node *prev = NULL;
+        int level = 0;
+        valid = true;
+        for(; valid && level < levels; ++level){
+            Node *pred = preds[level];
+            Node *succ = succs[level];
+            if(pred != prev){
+                pred->lock.lock();
+                prev = pred;
+            }
+            valid = !pred->marked.load() && (succ == NULL || succ == removing || !succ->marked.load())
+                && pred->next[level].load(std::memory_order_acquire) == succ;
+        }
+        return level;
+    }
+
+    static void unlockPreds(Node **preds, int levels){
+        Node *prev = NULL;
+        for(int level = 0; level < levels; ++level){
+            if(preds[level] != prev){
+                preds[level]->lock.unlock();
+                prev = preds[level];
+            }
+        }
+    }
+
+    /**
+     * Maps key to value unless it is present and onlyIfAbsent is set.
+     * Returns true if a new mapping was added.
+     */
+    bool insert(const K& key, const V& value, bool onlyIfAbsent){
+        EpochManager::Guard guard;
+        Node *preds[iMaxLevel];
+        Node *succs[iMaxLevel];
+        int topLevel = randomLevel();
+        while(true){
+            int found = find(key, preds, succs);
+            if(found != -1){
+                Node *tmp = succs[found];
+                if(tmp->marked.load()) continue;
+                while(!tmp->fullyLinked.load()) std::this_thread::yield();
+                if(!onlyIfAbsent){
+                    V *old = tmp->value.exchange(new V(value), std::memory_order_acq_rel);
+                    EpochManager::retire(old, destroyValue);
+                }
+                return false;
+            }
+            bool valid;
+            int locked = lockPreds(preds, succs, topLevel, NULL, valid);
+            if(!valid){
+                unlockPreds(preds, locked);
+                continue;
+            }
+            Node *tmp = createNode(key, new V(value), topLevel);
+            for(int level = 0; level < topLevel; ++level)
+                tmp->next[level].store(succs[level], std::memory_order_relaxed);
+            for(int level = 0; level < topLevel; ++level)
+                preds[level]->next[level].store(tmp, std::memory_order_release);
+            tmp->fullyLinked.store(true);
+            unlockPreds(preds, locked);
+            iSize.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+
+    /**
+     * Unlinks key. Returns false if it was not present.
+     */
+    bool erase(const K& key){
+        EpochManager::Guard guard;
+        Node *preds[iMaxLevel];
+        Node *succs[iMaxLevel];
+        Node *victim = NULL;
+        while(true){
+            int found = find(key, preds, succs);
+            if(victim == NULL){
+                if(found == -1) return false;
+                Node *tmp = succs[found];
+                if(!tmp->fullyLinked.load() || tmp->topLevel - 1 != found || tmp->marked.load()) return false;
+                tmp->lock.lock();
+                if(tmp->marked.load()){
+                    tmp->lock.unlock();
+                    return false;
+                }
+                tmp->marked.store(true);
+                victim = tmp;
+            }
+            bool valid;
+            Node *self[iMaxLevel];
+            for(int level = 0; level < victim->topLevel; ++level) self[level] = victim;
+            int locked = lockPreds(preds, self, victim->topLevel, victim, valid);
+            if(!valid){
+                unlockPreds(preds, locked);
+                continue;
+            }
+            for(int level = victim->topLevel - 1; level >= 0; --level)
+                preds[level]->next[level].store(victim->next[level].load(std::memory_order_relaxed), std::memory_order_release);
+            victim->lock.unlock();
+            unlockPreds(preds, locked);
+            iSize.fetch_sub(1, std::memory_order_relaxed);
+            EpochManager::retire(victim, destroyNode);
+            return true;
+        }
+    }
+
+public:
+    class Iterator
+    {
+    private:
+        EpochManager::Guard guard;
+        Node *pNext;
+        void skipDead(){
+            while(pNext != NULL && (pNext->marked.load() || !pNext->fullyLinked.load()))
+                pNext = pNext->next[0].load(std::memory_order_acquire);
+        }
+    public:
+        Iterator(const ConcurrentTreeMap *parMap){
+            pNext = parMap->pHead->next[0].load(std::memory_order_acquire);
+            skipDead();
+        }
+        /**
+         * Returns true if the iteration has more elements.
+         */
+        bool hasNext() {
+            return pNext != NULL;
+        }
+
+        /**
+         * Returns a copy of the next element in the iteration.
+         * @throw ElementNotExist exception when hasNext() == false
+         */
+        Entry next() {
+            if(!hasNext()) throw ElementNotExist();
+            Node *tmp = pNext;
+            pNext = tmp->next[0].load(std::memory_order_acquire);
+            skipDead();
+            return Entry(tmp->key, *tmp->value.load(std::memory_order_acquire));
+        }
+    };
+
+    /**
+     * Constructs an empty map.
+     */
+    ConcurrentTreeMap()
+    :pHead(createNode(K(), NULL, iMaxLevel)),iSize(0){
+        pHead->fullyLinked.store(true);
+    }
+
+    ConcurrentTreeMap(const ConcurrentTreeMap &) = delete;
+    ConcurrentTreeMap &operator=(const ConcurrentTreeMap &) = delete;
+
+    /**
+     * Destructor. No other thread may be using the map.
+     */
+    ~ConcurrentTreeMap() {
+        Node *tmp = pHead;
+        while(tmp != NULL){
+            Node *nxt = tmp->next[0].load(std::memory_order_relaxed);
+            destroyNode(tmp);
+            tmp = nxt;
+        }
+    }
+
+    /**
+     * Returns a weakly consistent iterator over the elements in this map.
+     */
+    Iterator iterator() const {
+        return Iterator(this);
+    }
+
+    /**
+     * Removes all of the mappings from this map, one at a time. Entries added
+     * concurrently may survive.
+     */
+    void clear() {
+        for(Iterator itr = iterator(); itr.hasNext();) erase(itr.next().getKey());
+    }
+
+    /**
+     * Returns true if this map contains a mapping for the specified key.
+     */
+    bool containsKey(const K &key) const {
+        EpochManager::Guard guard;
+        return lookup(key) != NULL;
+    }
+
+    /**
+     * Returns a copy of the value to which the specified key is mapped.
+     * @throw ElementNotExist
+     */
+    V get(const K &key) const {
+        EpochManager::Guard guard;
+        Node *tmp = lookup(key);
+        if(tmp == NULL) throw ElementNotExist();
+        return *tmp->value.load(std::memory_order_acquire);
+    }
+
+    /**
+     * Copies the value mapped to key into value and returns true, or returns
+     * false and leaves value untouched if the key is not present.
+     */
+    bool tryGet(const K &key, V &value) const {
+        EpochManager::Guard guard;
+        Node *tmp = lookup(key);
+        if(tmp == NULL) return false;
+        value = *tmp->value.load(std::memory_order_acquire);
+        return true;
+    }
+
+    /**
+     * Returns true if this map contains no key-value mappings.
+     */
+    bool isEmpty() const {
+        return size() == 0;
+    }
+
+    /**
+     * Associates the specified value with the specified key in this map.
+     */
+    void put(const K &key, const V &value) {
+        insert(key, value, false);
+    }
+
+    /**
+     * Maps key to value only if key is not present, atomically.
+     * Returns true if the mapping was added.
+     */
+    bool putIfAbsent(const K &key, const V &value) {
+        return insert(key, value, true);
+    }
+
+    /**
+     * Removes the mapping for the specified key from this map.
+     * @throw ElementNotExist
+     */
+    void remove(const K &key) {
+        if(!erase(key)) throw ElementNotExist();
+    }
+
+    /**
+     * Returns the number of key-value mappings in this map. Exact only when
+     * no update is in progress.
+     */
+    int size() const {
+        return iSize.load(std::memory_order_relaxed);
+    }
+};
+
+#endif
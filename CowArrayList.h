@@ -0,0 +1,352 @@
+/** @file */
+#ifndef __COWARRAYLIST_H
+#define __COWARRAYLIST_H
+
+#include <atomic>
+#include <utility>
+
+#include "IndexOutOfBound.h"
+#include "ElementNotExist.h"
+#include "ArrayList.h"
+
+/**
+ * CowArrayList is an ArrayList whose copies share one buffer until one of
+ * them is changed. Copying a list, or taking a snapshot(), is O(1); the
+ * first mutation of a shared copy (add, set, removeIndex, iterator remove,
+ * edit() and so on) copies the elements into a buffer of its own.
+ *
+ * Buffers are reference counted with atomic counters, so a snapshot may be
+ * handed to another thread and read there while the writer keeps changing
+ * its own copy. A single CowArrayList object is not itself safe to share
+ * between threads.
+ *
+ * Read-only operations not mirrored here, such as binarySearch or sum, are
+ * reached through list().
+ *
+ * The iterator iterates in the order of the elements being loaded into this list
+ */
+template<class T>
+class CowArrayList
+{
+private:
+    struct Buffer{
+        std::atomic<int> refs;
+        ArrayList<T> list;
+        Buffer()
+        :refs(1){}
+        Buffer(const ArrayList<T>& x)
+        :refs(1),list(x){}
+        Buffer(ArrayList<T>&& x)
+        :refs(1),list(std::move(x)){}
+    };
+
+    Buffer *pBuffer;
+
+    static Buffer* acquire(Buffer *buffer){
+        if(buffer != NULL) buffer->refs.fetch_add(1, std::memory_order_relaxed);
+        return buffer;
+    }
+
+    static void release(Buffer *buffer){
+        if(buffer == NULL || buffer->refs.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+        delete buffer;
+    }
+
+    static const ArrayList<T>& emptyList(){
+        static const ArrayList<T> list;
+        return list;
+    }
+
+    /**
+     * Makes the buffer this list's own, copying it if it is shared.
+     */
+    ArrayList<T>& unshare(){
+        if(pBuffer == NULL) pBuffer = new Buffer();
+        else if(pBuffer->refs.load(std::memory_order_acquire) != 1){
+            Buffer *tmp = new Buffer(pBuffer->list);
+            release(pBuffer);
+            pBuffer = tmp;
+        }
+        return pBuffer->list;
+    }
+
+public:
+    class Iterator
+    {
+    private:
+        int position;
+        CowArrayList *pArray;
+        bool ifPointed;
+    public:
+        Iterator(CowArrayList *parArray)
+        :position(0),pArray(parArray),ifPointed(false){}
+        /**
+         * Returns true if the iteration has more elements.
+         */
+        bool hasNext() {
+            int size = pArray->size();
+            if(position < size - 1) return true;
+            if((!ifPointed) && (position == size - 1)) return true;
+            return false;
+        }
+
+        /**
+         * Returns the next element in the iteration.
+         * @throw ElementNotExist exception when hasNext() == false
+         */
+        const T &next() {
+            if(!hasNext()) throw ElementNotExist();
+            if(ifPointed) ++position;
+            else ifPointed = true;
+            return pArray->get(position);
+        }
+
+        /**
+         * Removes from the underlying collection the last element returned
+         * by the iterator, first copying the elements if they are shared.
+         * @throw ElementNotExist
+         */
+        void remove() {
+            if(!ifPointed) throw ElementNotExist();
+            pArray->removeIndex(position);
+            ifPointed = false;
+        }
+    };
+
+    /**
+     *  Constructs an empty list. Nothing is allocated until the first add.
+     */
+    CowArrayList()
+    :pBuffer(NULL){}
+
+    /**
+     *  Takes over the elements of x.
+     */
+    explicit CowArrayList(ArrayList<T>&& x)
+    :pBuffer(new Buffer(std::move(x))){}
+
+    /**
+     *  Copies the elements of x.
+     */
+    explicit CowArrayList(const ArrayList<T>& x)
+    :pBuffer(new Buffer(x)){}
+
+    /**
+     *  Copy-constructor, O(1). The elements are shared until either list changes.
+     */
+    CowArrayList(const CowArrayList& x)
+    :pBuffer(acquire(x.pBuffer)){}
+
+    /**
+     *  Move-constructor. x is left empty.
+     */
+    CowArrayList(CowArrayList&& x) noexcept
+    :pBuffer(x.pBuffer) {
+        x.pBuffer = NULL;
+    }
+
+    /**
+     *  Destructor
+     */
+    ~CowArrayList() {
+        release(pBuffer);
+    }
+
+    /**
+     *  Assignment operator, O(1).
+     */
+    CowArrayList& operator=(const CowArrayList& x) {
+        Buffer *tmp = acquire(x.pBuffer);
+        release(pBuffer);
+        pBuffer = tmp;
+        return *this;
+    }
+
+    /**
+     *  Move assignment operator. x is left empty.
+     */
+    CowArrayList& operator=(CowArrayList&& x) noexcept {
+        if(this == &x) return *this;
+        release(pBuffer);
+        pBuffer = x.pBuffer;
+        x.pBuffer = NULL;
+        return *this;
+    }
+
+    /**
+     *  Exchanges the contents of this list and x in O(1).
+     */
+    void swap(CowArrayList& x) noexcept {
+        std::swap(pBuffer, x.pBuffer);
+    }
+
+    /**
+     *  Returns a copy of this list that shares its elements, in O(1).
+     */
+    CowArrayList snapshot() const {
+        return *this;
+    }
+
+    /**
+     *  Returns true if the elements are shared with another copy.
+     */
+    bool isShared() const {
+        return pBuffer != NULL && pBuffer->refs.load(std::memory_order_acquire) != 1;
+    }
+
+    /**
+     *  Returns the elements as a read-only ArrayList. The reference is
+     * invalidated by the next change to this list.
+     */
+    const ArrayList<T>& list() const {
+        return pBuffer != NULL ? pBuffer->list : emptyList();
+    }
+
+    /**
+     *  Returns the elements as an ArrayList that may be changed in place,
+     * copying them first if they are shared. The reference is invalidated
+     * by the next copy of this list.
+     */
+    ArrayList<T>& edit() {
+        return unshare();
+    }
+
+    /**
+     *  Appends the specified element to the end of this list.
+     * Always returns true.
+     */
+    bool add(const T& e) {
+        return unshare().add(e);
+    }
+
+    /**
+     *  Appends the specified element to the end of this list, moving it in.
+     * Always returns true.
+     */
+    bool add(T&& e) {
+        return unshare().add(std::move(e));
+    }
+
+    /**
+     *  Inserts the specified element to the specified position in this list.
+     * The range of index parameter is [0, size].
+     * @throw IndexOutOfBound
+     */
+    void add(int index, const T& element) {
+        if(index < 0 || index > size()) throw IndexOutOfBound();
+        unshare().add(index, element);
+    }
+
+    /**
+     *  Removes all of the elements from this list. Shared elements are
+     * left to the other copies instead of being copied.
+     */
+    void clear() {
+        if(isShared()){
+            release(pBuffer);
+            pBuffer = NULL;
+        }
+        else if(pBuffer != NULL) pBuffer->list.clear();
+    }
+
+    /**
+     *  Returns true if this list contains the specified element.
+     */
+    bool contains(const T& e) const {
+        return list().contains(e);
+    }
+
+    /**
+     *  Returns the index of the first occurrence of the specified element, or -1.
+     */
+    int indexOf(const T& e) const {
+        return list().indexOf(e);
+    }
+
+    /**
+     *  Returns the index of the last occurrence of the specified element, or -1.
+     */
+    int lastIndexOf(const T& e) const {
+        return list().lastIndexOf(e);
+    }
+
+    /**
+     *  Returns a const reference to the element at the specified position in this list.
+     * The index is zero-based, with range [0, size).
+     * @throw IndexOutOfBound
+     */
+    const T& get(int index) const {
+        return list().get(index);
+    }
+
+    /**
+     *  Copies the element at the specified position into element and returns true,
+     * or returns false and leaves element untouched if the index is out of range.
+     */
+    bool tryGet(int index, T& element) const {
+        return list().tryGet(index, element);
+    }
+
+    /**
+     *  Returns the element at the specified position, or defaultValue if the
+     * index is out of range.
+     */
+    T getOrDefault(int index, const T& defaultValue) const {
+        return list().getOrDefault(index, defaultValue);
+    }
+
+    /**
+     *  Returns true if this list contains no elements.
+     */
+    bool isEmpty() const {
+        return size() == 0;
+    }
+
+    /**
+     *  Removes the element at the specified position in this list.
+     * The index is zero-based, with range [0, size).
+     * @throw IndexOutOfBound
+     */
+    void removeIndex(int index) {
+        if(index < 0 || index >= size()) throw IndexOutOfBound();
+        unshare().removeIndex(index);
+    }
+
+    /**
+     *  Removes the first occurrence of the specified element from this list, if it is present.
+     * Returns true if it was present in the list, otherwise false. Nothing is
+     * copied if the element is not found.
+     */
+    bool remove(const T &e) {
+        int p = indexOf(e);
+        if(p < 0) return false;
+        unshare().removeIndex(p);
+        return true;
+    }
+
+    /**
+     *  Replaces the element at the specified position in this list with the specified element.
+     * The index is zero-based, with range [0, size).
+     * @throw IndexOutOfBound
+     */
+    void set(int index, const T &element) {
+        if(index < 0 || index >= size()) throw IndexOutOfBound();
+        unshare().set(index, element);
+    }
+
+    /**
+     *  Returns the number of elements in this list.
+     */
+    int size() const {
+        return pBuffer != NULL ? pBuffer->list.size() : 0;
+    }
+
+    /**
+     *  Returns an iterator over the elements in this list.
+     */
+    Iterator iterator() {
+        return Iterator(this);
+    }
+};
+
+#endif
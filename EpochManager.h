@@ -0,0 +1,191 @@
+/** @file */
+#ifndef __EPOCHMANAGER_H
+#define __EPOCHMANAGER_H
+
+#include <atomic>
+#include <mutex>
+
+#include "ArrayList.h"
+
+/**
+ * Epoch-based reclamation for lock-free readers.
+ *
+ * A thread reads shared nodes only while it holds a Guard. A writer that
+ * unlinks a node hands it to retire() instead of freeing it; the node is
+ * freed once every thread that was inside a Guard when it was unlinked has
+ * left it. This is tracked with a global epoch counter that only advances
+ * when every thread inside a Guard has observed the current epoch, so a node
+ * retired in epoch e is unreachable by anyone once the epoch reaches e + 2.
+ *
+ * Guards nest, cost two atomic stores, and never block. Retired nodes are
+ * kept in a per-thread list and collected in batches; whatever is left when
+ * a thread exits is handed over to the other threads.
+ */
+class EpochManager
+{
+public:
+    /**
+     * Marks the current thread as reading shared nodes while it exists.
+     */
+    class Guard
+    {
+    public:
+        Guard() {
+            enter();
+        }
+        Guard(const Guard &) {
+            enter();
+        }
+        Guard &operator=(const Guard &) {
+            return *this;
+        }
+        ~Guard() {
+            exit();
+        }
+    };
+
+    /**
+     * Frees p with deleter once no thread can still be reading it.
+     * p must already be unreachable for threads entering a Guard from now on.
+     */
+    static void retire(void *p, void (*deleter)(void*)) {
+        Local &local = current();
+        Retired tmp = { p, deleter, globalEpoch().load() };
+        local.limbo.add(tmp);
+        if(local.limbo.size() >= local.collectAt){
+            collect(local);
+            local.collectAt = local.limbo.size() * 2 > iCollectBatch ? local.limbo.size() * 2 : iCollectBatch;
+        }
+    }
+
+private:
+    static const int iCollectBatch = 64;
+
+    struct Record{
+        std::atomic<unsigned long> epoch;
+        std::atomic<bool> active;
+        std::atomic<bool> inUse;
+        Record *next;
+    };
+
+    struct Retired{
+        void *p;
+        void (*deleter)(void*);
+        unsigned long epoch;
+    };
+
+    /**
+     * collectAt is the limbo size that triggers the next collection. It is
+     * twice what the last one had to keep, so while a stalled reader holds
+     * the epoch back each retire still costs amortized O(1).
+     */
+    struct Local{
+        Record *record;
+        int depth;
+        int collectAt;
+        ArrayList<Retired> limbo;
+        Local():record(acquireRecord()),depth(0),collectAt(iCollectBatch){}
+        ~Local(){
+            collect(*this);
+            if(!limbo.isEmpty()){
+                std::lock_guard<std::mutex> lock(orphanLock());
+                for(int i=0; i<limbo.size(); ++i) orphans().add(limbo.get(i));
+            }
+            record->inUse.store(false);
+        }
+    };
+
+    static std::atomic<unsigned long> &globalEpoch() {
+        static std::atomic<unsigned long> epoch(0);
+        return epoch;
+    }
+
+    static std::atomic<Record*> &records() {
+        static std::atomic<Record*> head(NULL);
+        return head;
+    }
+
+    static std::mutex &orphanLock() {
+        static std::mutex lock;
+        return lock;
+    }
+
+    static ArrayList<Retired> &orphans() {
+        static ArrayList<Retired> list;
+        return list;
+    }
+
+    static Local &current() {
+        static thread_local Local local;
+        return local;
+    }
+
+    /**
+     * Reuses the record of an exited thread, or registers a new one.
+     * Records are never freed, so the list can be walked without locking.
+     */
+    static Record *acquireRecord() {
+        for(Record *tmp = records().load(); tmp != NULL; tmp = tmp->next){
+            bool expected = false;
+            if(tmp->inUse.compare_exchange_strong(expected, true)) return tmp;
+        }
+        Record *tmp = new Record;
+        tmp->epoch.store(0);
+        tmp->active.store(false);
+        tmp->inUse.store(true);
+        tmp->next = records().load();
+        while(!records().compare_exchange_weak(tmp->next, tmp));
+        return tmp;
+    }
+
+    static void enter() {
+        Local &local = current();
+        if(local.depth++ > 0) return;
+        local.record->active.store(true);
+        local.record->epoch.store(globalEpoch().load());
+    }
+
+    static void exit() {
+        Local &local = current();
+        if(--local.depth > 0) return;
+        local.record->active.store(false);
+    }
+
+    /**
+     * Moves the global epoch forward if every active thread has seen it.
+     */
+    static void tryAdvance() {
+        unsigned long epoch = globalEpoch().load();
+        for(Record *tmp = records().load(); tmp != NULL; tmp = tmp->next){
+            if(tmp->inUse.load() && tmp->active.load() && tmp->epoch.load() != epoch) return;
+        }
+        globalEpoch().compare_exchange_strong(epoch, epoch + 1);
+    }
+
+    /**
+     * Frees the entries of list retired two or more epochs ago, keeping the rest.
+     */
+    static void freeExpired(ArrayList<Retired> &list) {
+        unsigned long epoch = globalEpoch().load();
+        int kept = 0;
+        for(int i=0; i<list.size(); ++i){
+            Retired tmp = list.get(i);
+            if(tmp.epoch + 2 <= epoch) tmp.deleter(tmp.p);
+            else list.set(kept++, tmp);
+        }
+        while(list.size() > kept) list.removeIndex(list.size() - 1);
+    }
+
+    /**
+     * Safe inside a Guard too: the caller's own epoch keeps the global one
+     * from passing anything it could still be reading.
+     */
+    static void collect(Local &local) {
+        tryAdvance();
+        freeExpired(local.limbo);
+        std::unique_lock<std::mutex> lock(orphanLock(), std::try_to_lock);
+        if(lock.owns_lock()) freeExpired(orphans());
+    }
+};
+
+#endif
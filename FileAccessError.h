@@ -0,0 +1,20 @@
+/** @file FileAccessError.h
+ * Thrown when a file cannot be opened, mapped, resized or synced, or does
+ * not hold what it should.
+ * For example, opening a MappedArrayList on a file of another format raises this exception.
+ */
+
+#include <string>
+
+#ifndef __FILEACCESSERROR_H
+#define __FILEACCESSERROR_H
+
+class FileAccessError {
+public:
+    FileAccessError() {}
+    FileAccessError(std::string msg) : msg(msg) {}
+    std::string getMessage() const { return msg; }
+private:
+    std::string msg;
+};
+#endif
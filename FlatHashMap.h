@@ -0,0 +1,591 @@
+/** @file */
+
+#ifndef __FLATHASHMAP_H
+#define __FLATHASHMAP_H
+
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <utility>
+#include <stdint.h>
+
+#if defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+
+#include "ElementNotExist.h"
+
+/**
+ * FlatHashMap is an open-addressing HashMap with the same interface and the
+ * same hash function contract: H::hashCode(key) returns an int and equal keys
+ * must hash equally.
+ *
+ * All entries live in one contiguous slot array. Next to it is an array with
+ * one control byte per slot which is either empty, deleted, or holds the low
+ * 7 bits of the slot's hash. A lookup loads a whole group of control bytes at
+ * once (32 with AVX2, 16 with SSE2, 8 otherwise), compares them against the
+ * tag in one instruction and only touches the slots whose tag matched. Groups
+ * are probed in triangular order, so every slot is eventually visited.
+ *
+ * The table is allocated on the first put and is kept at most 7/8 full. The
+ * first group of control bytes is mirrored after the last one, so a group may
+ * be loaded at any slot without wrapping.
+ *
+ * Entries move when the table grows, so references returned by get are only
+ * valid until the next put. The order of iteration is arbitary.
+ */
+template <class K, class V, class H>
+class FlatHashMap
+{
+public:
+    class Entry
+    {
+        K key;
+        V value;
+    public:
+        Entry(const K& k, const V& v)
+        :key(k),value(v){}
+        void setValue(const V& v){
+            value = v;
+        }
+
+        const K& getKey() const
+        {
+            return key;
+        }
+
+        const V& getValue() const
+        {
+            return value;
+        }
+    };
+private:
+    typedef signed char ctrl_t;
+    static const ctrl_t kEmpty = -128;
+    static const ctrl_t kDeleted = -2;
+
+    /**
+     * A group of control bytes starting at an arbitrary slot. Every match
+     * returns a bitmask with bit i set when the i-th byte of the group matches.
+     */
+    struct Group{
+#if defined(__AVX2__)
+        static const int kWidth = 32;
+        __m256i ctrl;
+        explicit Group(const ctrl_t *pos)
+        :ctrl(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(pos))){}
+        uint32_t match(ctrl_t tag) const {
+            return _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_set1_epi8(tag), ctrl));
+        }
+        uint32_t matchEmpty() const {
+            return match(kEmpty);
+        }
+        uint32_t matchEmptyOrDeleted() const {
+            return _mm256_movemask_epi8(_mm256_cmpgt_epi8(_mm256_set1_epi8(-1), ctrl));
+        }
+        uint32_t matchFull() const {
+            return ~static_cast<uint32_t>(_mm256_movemask_epi8(ctrl));
+        }
+#elif defined(__SSE2__) || defined(_M_X64)
+        static const int kWidth = 16;
+        __m128i ctrl;
+        explicit Group(const ctrl_t *pos)
+        :ctrl(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pos))){}
+        uint32_t match(ctrl_t tag) const {
+            return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(tag), ctrl));
+        }
+        uint32_t matchEmpty() const {
+            return match(kEmpty);
+        }
+        uint32_t matchEmptyOrDeleted() const {
+            return _mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(-1), ctrl));
+        }
+        uint32_t matchFull() const {
+            return ~_mm_movemask_epi8(ctrl) & 0xFFFF;
+        }
+#else
+        static const int kWidth = 8;
+        ctrl_t ctrl[kWidth];
+        explicit Group(const ctrl_t *pos){
+            memcpy(ctrl, pos, kWidth);
+        }
+        uint32_t match(ctrl_t tag) const {
+            uint32_t mask = 0;
+            for(int i=0; i<kWidth; ++i) if(ctrl[i] == tag) mask |= 1U << i;
+            return mask;
+        }
+        uint32_t matchEmpty() const {
+            return match(kEmpty);
+        }
+        uint32_t matchEmptyOrDeleted() const {
+            uint32_t mask = 0;
+            for(int i=0; i<kWidth; ++i) if(ctrl[i] < -1) mask |= 1U << i;
+            return mask;
+        }
+        uint32_t matchFull() const {
+            uint32_t mask = 0;
+            for(int i=0; i<kWidth; ++i) if(ctrl[i] >= 0) mask |= 1U << i;
+            return mask;
+        }
+#endif
+    };
+
+    static const int kGroupWidth = Group::kWidth;
+
+    ctrl_t *iCtrl;
+    Entry *iSlots;
+    int iCapacity;
+    int iSize;
+    int iGrowthLeft;
+
+    static int lowestBit(uint32_t mask) {
+#if defined(__GNUC__)
+        return __builtin_ctz(mask);
+#else
+        int i = 0;
+        while(!(mask & 1)){ mask >>= 1; ++i; }
+        return i;
+#endif
+    }
+
+    static uint64_t hashOf(const K& obj) {
+        uint64_t hash = static_cast<uint32_t>(H::hashCode(obj));
+        hash ^= hash >> 33;
+        hash *= 0xff51afd7ed558ccdULL;
+        hash ^= hash >> 33;
+        hash *= 0xc4ceb9fe1a85ec53ULL;
+        hash ^= hash >> 33;
+        return hash;
+    }
+
+    static ctrl_t tagOf(uint64_t hash) {
+        return static_cast<ctrl_t>(hash & 0x7F);
+    }
+
+    static int maxLoad(int capacity) {
+        return capacity - capacity / 8;
+    }
+
+    static int roundUpCapacity(int n) {
+        int capacity = kGroupWidth;
+        while(maxLoad(capacity) < n) capacity <<= 1;
+        return capacity;
+    }
+
+    int firstProbe(uint64_t hash) const {
+        return static_cast<int>((hash >> 7) & (iCapacity - 1));
+    }
+
+    void setCtrl(int index, ctrl_t tag) {
+        iCtrl[index] = tag;
+        if(index < kGroupWidth) iCtrl[iCapacity + index] = tag;
+    }
+
+    /**
+     * Returns the slot holding key, or -1 if it is not in the map.
+     */
+    int findSlot(const K& key, uint64_t hash) const {
+        if(iCapacity == 0) return -1;
+        ctrl_t tag = tagOf(hash);
+        for(int pos = firstProbe(hash), stride = 0;;){
+            Group g(iCtrl + pos);
+            for(uint32_t mask = g.match(tag); mask; mask &= mask - 1){
+                int index = (pos + lowestBit(mask)) & (iCapacity - 1);
+                if(iSlots[index].getKey() == key) return index;
+            }
+            if(g.matchEmpty()) return -1;
+            stride += kGroupWidth;
+            pos = (pos + stride) & (iCapacity - 1);
+        }
+    }
+
+    /**
+     * Returns the first empty or deleted slot on the probe sequence of hash.
+     * The table is never full, so one always exists.
+     */
+    int findInsertSlot(uint64_t hash) const {
+        for(int pos = firstProbe(hash), stride = 0;;){
+            uint32_t mask = Group(iCtrl + pos).matchEmptyOrDeleted();
+            if(mask) return (pos + lowestBit(mask)) & (iCapacity - 1);
+            stride += kGroupWidth;
+            pos = (pos + stride) & (iCapacity - 1);
+        }
+    }
+
+    /**
+     * Replaces the table with an empty one of the given capacity, without
+     * freeing the old one. If allocation fails the map is left unchanged.
+     */
+    void allocate(int capacity) {
+        ctrl_t *ctrl = static_cast<ctrl_t*>(malloc(capacity + kGroupWidth));
+        Entry *slots = static_cast<Entry*>(malloc(sizeof(Entry) * capacity));
+        if(ctrl == NULL || slots == NULL){
+            free(ctrl);
+            free(slots);
+            throw std::bad_alloc();
+        }
+        memset(ctrl, kEmpty, capacity + kGroupWidth);
+        iCtrl = ctrl;
+        iSlots = slots;
+        iCapacity = capacity;
+        iGrowthLeft = maxLoad(capacity);
+    }
+
+    void release() {
+        for(int i=0; i<iCapacity; ++i)
+            if(iCtrl[i] >= 0) iSlots[i].~Entry();
+        free(iCtrl);
+        free(iSlots);
+        iCtrl = NULL;
+        iSlots = NULL;
+        iCapacity = 0;
+        iSize = 0;
+        iGrowthLeft = 0;
+    }
+
+    /**
+     * Rebuilds the table with the given capacity, dropping all tombstones.
+     * Entries are moved, or copied if their move may throw; the old table
+     * is only destroyed once every entry is in the new one, so a throwing
+     * copy leaves the map as it was.
+     */
+    void resize(int capacity) {
+        ctrl_t *oldCtrl = iCtrl;
+        Entry *oldSlots = iSlots;
+        int oldCapacity = iCapacity;
+        int oldGrowthLeft = iGrowthLeft;
+        allocate(capacity);
+        try{
+            for(int i=0; i<oldCapacity; ++i){
+                if(oldCtrl[i] < 0) continue;
+                uint64_t hash = hashOf(oldSlots[i].getKey());
+                int index = findInsertSlot(hash);
+                new (iSlots + index) Entry(std::move_if_noexcept(oldSlots[i]));
+                setCtrl(index, tagOf(hash));
+            }
+        }
+        catch(...){
+            int size = iSize;
+            release();
+            iCtrl = oldCtrl;
+            iSlots = oldSlots;
+            iCapacity = oldCapacity;
+            iSize = size;
+            iGrowthLeft = oldGrowthLeft;
+            throw;
+        }
+        for(int i=0; i<oldCapacity; ++i)
+            if(oldCtrl[i] >= 0) oldSlots[i].~Entry();
+        iGrowthLeft -= iSize;
+        free(oldCtrl);
+        free(oldSlots);
+    }
+
+    /**
+     * Called when no empty slot may be consumed any more. If most of the
+     * used-up room is tombstones the table is cleaned in place, otherwise
+     * it doubles.
+     */
+    void makeRoom() {
+        if(iCapacity == 0) allocate(kGroupWidth);
+        else if(iSize <= maxLoad(iCapacity) / 2) resize(iCapacity);
+        else resize(iCapacity * 2);
+    }
+
+    /**
+     * Stores a key known to be absent and returns its slot. key and value
+     * may refer into this map, so when the table has to be rebuilt the
+     * entry is made before the old slots are freed.
+     */
+    int insertSlot(const K& key, const V& value, uint64_t hash) {
+        int index = iCapacity == 0 ? -1 : findInsertSlot(hash);
+        if(index < 0 || (iCtrl[index] == kEmpty && iGrowthLeft == 0)){
+            Entry tmp(key, value);
+            makeRoom();
+            index = findInsertSlot(hash);
+            new (iSlots + index) Entry(std::move(tmp));
+        }
+        else new (iSlots + index) Entry(key, value);
+        if(iCtrl[index] == kEmpty) --iGrowthLeft;
+        setCtrl(index, tagOf(hash));
+        ++iSize;
+        return index;
+    }
+
+    /**
+     * Copies x into this empty map slot by slot. A control byte is only
+     * marked full once its entry is built, so if a copy throws the map is
+     * released and left empty.
+     */
+    void copyFrom(const FlatHashMap &x) {
+        if(x.iSize == 0) return;
+        allocate(x.iCapacity);
+        try{
+            for(int i=0; i<iCapacity; ++i){
+                if(x.iCtrl[i] >= 0){
+                    new (iSlots + i) Entry(x.iSlots[i]);
+                    ++iSize;
+                }
+                if(x.iCtrl[i] != kEmpty) setCtrl(i, x.iCtrl[i]);
+            }
+        }
+        catch(...){
+            release();
+            throw;
+        }
+        iGrowthLeft = x.iGrowthLeft;
+    }
+
+    void takeFrom(FlatHashMap &x) {
+        iCtrl = x.iCtrl;
+        iSlots = x.iSlots;
+        iCapacity = x.iCapacity;
+        iSize = x.iSize;
+        iGrowthLeft = x.iGrowthLeft;
+        x.iCtrl = NULL;
+        x.iSlots = NULL;
+        x.iCapacity = 0;
+        x.iSize = 0;
+        x.iGrowthLeft = 0;
+    }
+
+    /**
+     * Returns the first full slot at or after index, or -1 if there is none.
+     */
+    int nextFull(int index) const {
+        while(index < iCapacity){
+            uint32_t mask = Group(iCtrl + index).matchFull();
+            if(mask) {
+                index += lowestBit(mask);
+                return index < iCapacity ? index : -1;
+            }
+            index += kGroupWidth;
+        }
+        return -1;
+    }
+
+public:
+    class Iterator
+    {
+    private:
+        const FlatHashMap* pHashMap;
+        int iNext;
+    public:
+        Iterator(const FlatHashMap* parHashMap)
+            :pHashMap(parHashMap){
+            iNext = pHashMap->nextFull(0);
+        }
+
+        /**
+         * Returns true if the iteration has more elements.
+         */
+        bool hasNext() {
+            return iNext >= 0;
+        }
+
+        /**
+         * Returns the next element in the iteration.
+         * @throw ElementNotExist exception when hasNext() == false
+         */
+        const Entry &next() {
+            if(iNext < 0) throw ElementNotExist();
+            int index = iNext;
+            iNext = pHashMap->nextFull(index + 1);
+            return pHashMap->iSlots[index];
+        }
+    };
+
+    /**
+     * Constructs an empty hash map.
+     */
+    FlatHashMap()
+    :iCtrl(NULL),iSlots(NULL),iCapacity(0),iSize(0),iGrowthLeft(0){}
+
+    /**
+     * Destructor
+     */
+    ~FlatHashMap() {
+        release();
+    }
+
+    /**
+     * Assignment operator
+     */
+    FlatHashMap &operator=(const FlatHashMap &x) {
+        if(this == &x) return *this;
+        release();
+        copyFrom(x);
+        return *this;
+    }
+
+    /**
+     * Copy-constructor
+     */
+    FlatHashMap(const FlatHashMap &x)
+    :iCtrl(NULL),iSlots(NULL),iCapacity(0),iSize(0),iGrowthLeft(0){
+        copyFrom(x);
+    }
+
+    /**
+     * Move-constructor. x is left empty.
+     */
+    FlatHashMap(FlatHashMap &&x) noexcept
+    :iCtrl(NULL),iSlots(NULL),iCapacity(0),iSize(0),iGrowthLeft(0){
+        takeFrom(x);
+    }
+
+    /**
+     * Move assignment operator. x is left empty.
+     */
+    FlatHashMap &operator=(FlatHashMap &&x) noexcept {
+        if(this == &x) return *this;
+        release();
+        takeFrom(x);
+        return *this;
+    }
+
+    /**
+     * Returns an iterator over the elements in this map.
+     */
+    Iterator iterator() const {
+        return Iterator(this);
+    }
+
+    /**
+     * Removes all of the mappings from this map.
+     */
+    void clear() {
+        release();
+    }
+
+    /**
+     * Makes room for at least n entries so that they can be put without
+     * any further resizing.
+     */
+    void reserve(int n) {
+        if(n <= iSize + iGrowthLeft) return;
+        int capacity = roundUpCapacity(n);
+        if(iCapacity == 0) allocate(capacity);
+        else resize(capacity);
+    }
+
+    /**
+     * Returns true if this map contains a mapping for the specified key.
+     */
+    bool containsKey(const K &key) const {
+        return findSlot(key, hashOf(key)) >= 0;
+    }
+
+    /**
+     * Returns true if this map maps one or more keys to the specified value.
+     */
+    bool containsValue(const V &value) const {
+        for(int i = nextFull(0); i >= 0; i = nextFull(i + 1))
+            if(iSlots[i].getValue() == value) return true;
+        return false;
+    }
+
+    /**
+     * Returns a const reference to the value to which the specified key is mapped.
+     * If the key is not present in this map, this function should throw ElementNotExist exception.
+     * @throw ElementNotExist
+     */
+    const V &get(const K &key) const {
+        int index = findSlot(key, hashOf(key));
+        if(index < 0) throw ElementNotExist();
+        return iSlots[index].getValue();
+    }
+
+    /**
+     * Returns the entry mapped to key, or NULL if the key is not present.
+     * Unlike get, a miss does not throw.
+     */
+    const Entry *find(const K &key) const {
+        int index = findSlot(key, hashOf(key));
+        return index < 0 ? NULL : iSlots + index;
+    }
+
+    /**
+     * Copies the value mapped to key into value and returns true, or
+     * returns false and leaves value untouched if the key is not present.
+     */
+    bool tryGet(const K &key, V &value) const {
+        const Entry *tmp = find(key);
+        if(tmp == NULL) return false;
+        value = tmp->getValue();
+        return true;
+    }
+
+    /**
+     * Returns the value mapped to key, or defaultValue if the key is not present.
+     */
+    V getOrDefault(const K &key, const V &defaultValue) const {
+        const Entry *tmp = find(key);
+        return tmp == NULL ? defaultValue : tmp->getValue();
+    }
+
+    /**
+     * Returns true if this map contains no key-value mappings.
+     */
+    bool isEmpty() const {
+        return (iSize == 0);
+    }
+
+    /**
+     * Associates the specified value with the specified key in this map.
+     */
+    void put(const K &key, const V &value) {
+        uint64_t hash = hashOf(key);
+        int index = findSlot(key, hash);
+        if(index >= 0){
+            iSlots[index].setValue(value);
+            return;
+        }
+        insertSlot(key, value, hash);
+    }
+
+    /**
+     * Associates the specified value with the specified key only if the key
+     * is not already mapped. Returns true if the value was put.
+     */
+    bool putIfAbsent(const K &key, const V &value) {
+        uint64_t hash = hashOf(key);
+        if(findSlot(key, hash) >= 0) return false;
+        insertSlot(key, value, hash);
+        return true;
+    }
+
+    /**
+     * Returns the value mapped to key, first mapping it to fn(key) if the
+     * key is absent. fn is only called when the key is absent.
+     */
+    template <class F>
+    const V &computeIfAbsent(const K &key, F fn) {
+        uint64_t hash = hashOf(key);
+        int index = findSlot(key, hash);
+        if(index < 0) index = insertSlot(key, fn(key), hash);
+        return iSlots[index].getValue();
+    }
+
+    /**
+     * Removes the mapping for the specified key from this map if present.
+     * If there is no mapping for the specified key, throws ElementNotExist exception.
+     * @throw ElementNotExist
+     */
+    void remove(const K &key) {
+        int index = findSlot(key, hashOf(key));
+        if(index < 0) throw ElementNotExist();
+        iSlots[index].~Entry();
+        setCtrl(index, kDeleted);
+        --iSize;
+    }
+
+    /**
+     * Returns the number of key-value mappings in this map.
+     */
+    int size() const {
+        return iSize;
+    }
+};
+
+#endif
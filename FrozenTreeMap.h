@@ -0,0 +1,337 @@
+/** @file */
+#ifndef __FROZENTREEMAP_H
+#define __FROZENTREEMAP_H
+
+#include "ElementNotExist.h"
+
+/**
+ * FrozenTreeMap is a read-only snapshot of an ordered map, for maps that are
+ * built once and then only searched.
+ *
+ * The keys are stored in one array in Eytzinger order: the implicit binary
+ * search tree rooted at index 1 with children 2k and 2k+1, laid out level by
+ * level. The values sit at the same indices of a parallel array and are only
+ * touched once the key is found. A search walks down with k = 2k + (key > k-th
+ * key), which compiles to a conditional move instead of a branch, and
+ * prefetches the cache line holding the node several levels below, so the
+ * misses of successive levels overlap. The map holds no pointers or
+ * per-node allocations, so for small keys and values it takes a fraction of
+ * the memory of the treap it was built from.
+ *
+ * The iterators iterate through the map in the natural order (operator<) of
+ * the key, stepping through the implicit tree in amortized O(1).
+ */
+template<class K, class V>
+class FrozenTreeMap
+{
+public:
+    /**
+     * A view of one mapping, valid while the map exists. The entry find
+     * returns for a missing key is empty; an Entry tests and dereferences
+     * like the entry pointer the other maps return.
+     */
+    class Entry
+    {
+        const K *key;
+        const V *value;
+    public:
+        Entry(const K& k, const V& v)
+        :key(&k),value(&v){}
+        Entry()
+        :key(NULL),value(NULL){}
+
+        explicit operator bool() const
+        {
+            return key != NULL;
+        }
+
+        const Entry *operator->() const
+        {
+            return this;
+        }
+
+        const K& getKey() const
+        {
+            return *key;
+        }
+
+        const V& getValue() const
+        {
+            return *value;
+        }
+    };
+
+private:
+    K *iKeys;
+    V *iValues;
+    int iSize;
+
+    /**
+     * The 16 descendants of k four levels down are contiguous from k * 16;
+     * for 4-byte keys they share the cache line that is prefetched.
+     */
+    static const int iPrefetchDepth = 16;
+
+    /**
+     * Places the sorted entries produced by itr at the in-order positions
+     * of the subtree rooted at k.
+     */
+    template<class Iter>
+    void fill(Iter &itr, int k){
+        if(k > iSize) return;
+        fill(itr, 2 * k);
+        assign(itr.next(), iKeys[k], iValues[k]);
+        fill(itr, 2 * k + 1);
+    }
+
+    template<class E>
+    static void assign(const E& entry, K& key, V& value){
+        key = entry.getKey();
+        value = entry.getValue();
+    }
+
+    void prefetch(int k) const{
+#if defined(__GNUC__)
+        if(k <= iSize / iPrefetchDepth) __builtin_prefetch(iKeys + k * iPrefetchDepth);
+#endif
+    }
+
+    /**
+     * Undoes the trailing right turns of a finished descent: the answer is
+     * the last node where the search went left, or 0 if it never did.
+     */
+    static int lastLeftTurn(unsigned int k){
+        while(k & 1) k >>= 1;
+        return k >> 1;
+    }
+
+    /**
+     * Index of the least key not less than key, or 0.
+     */
+    int lowerBound(const K& key) const{
+        unsigned int k = 1;
+        while(k <= static_cast<unsigned int>(iSize)){
+            prefetch(k);
+            k = 2 * k + (iKeys[k] < key);
+        }
+        return lastLeftTurn(k);
+    }
+
+    /**
+     * Index of the least key greater than key, or 0.
+     */
+    int upperBound(const K& key) const{
+        unsigned int k = 1;
+        while(k <= static_cast<unsigned int>(iSize)){
+            prefetch(k);
+            k = 2 * k + !(key < iKeys[k]);
+        }
+        return lastLeftTurn(k);
+    }
+
+    int first() const{
+        if(iSize == 0) return 0;
+        int k = 1;
+        while(2 * k <= iSize) k *= 2;
+        return k;
+    }
+
+    int last() const{
+        if(iSize == 0) return 0;
+        int k = 1;
+        while(2 * k + 1 <= iSize) k = 2 * k + 1;
+        return k;
+    }
+
+    /**
+     * In-order successor of k, or 0.
+     */
+    int successor(int k) const{
+        if(2 * k + 1 <= iSize){
+            k = 2 * k + 1;
+            while(2 * k <= iSize) k *= 2;
+            return k;
+        }
+        return lastLeftTurn(k);
+    }
+
+    /**
+     * In-order predecessor of k, or 0.
+     */
+    int predecessor(int k) const{
+        if(2 * k <= iSize){
+            k = 2 * k;
+            while(2 * k + 1 <= iSize) k = 2 * k + 1;
+            return k;
+        }
+        while(k > 1 && !(k & 1)) k >>= 1;
+        return k >> 1;
+    }
+
+    int indexOf(const K& key) const{
+        int k = lowerBound(key);
+        return (k != 0 && !(key < iKeys[k])) ? k : 0;
+    }
+
+    void copyFrom(const FrozenTreeMap &x){
+        iSize = x.iSize;
+        iKeys = new K[iSize + 1];
+        iValues = new V[iSize + 1];
+        for(int i=1; i<=iSize; ++i){
+            iKeys[i] = x.iKeys[i];
+            iValues[i] = x.iValues[i];
+        }
+    }
+
+public:
+    class Iterator
+    {
+    private:
+        const FrozenTreeMap *pMap;
+        int iNext;
+    public:
+        Iterator(const FrozenTreeMap *parMap, int parNext)
+        :pMap(parMap),iNext(parNext){}
+        /**
+         * Returns true if the iteration has more elements.
+         */
+        bool hasNext() {
+            return iNext != 0;
+        }
+
+        /**
+         * Returns the next element in the iteration.
+         * @throw ElementNotExist exception when hasNext() == false
+         */
+        Entry next() {
+            if(!hasNext()) throw ElementNotExist();
+            int k = iNext;
+            iNext = pMap->successor(k);
+            return Entry(pMap->iKeys[k], pMap->iValues[k]);
+        }
+    };
+
+    /**
+     * Builds a frozen copy of map, which must iterate in ascending key
+     * order, as TreeMap and BPlusTreeMap do. Takes O(n).
+     */
+    template<class M>
+    explicit FrozenTreeMap(const M &map)
+    :iSize(map.size()){
+        iKeys = new K[iSize + 1];
+        iValues = new V[iSize + 1];
+        decltype(map.iterator()) itr = map.iterator();
+        fill(itr, 1);
+    }
+
+    /**
+     * Copy-constructor
+     */
+    FrozenTreeMap(const FrozenTreeMap &x) {
+        copyFrom(x);
+    }
+
+    /**
+     * Assignment operator
+     */
+    FrozenTreeMap &operator=(const FrozenTreeMap &x) {
+        if(this == &x) return *this;
+        delete[] iKeys;
+        delete[] iValues;
+        copyFrom(x);
+        return *this;
+    }
+
+    /**
+     * Destructor
+     */
+    ~FrozenTreeMap() {
+        delete[] iKeys;
+        delete[] iValues;
+    }
+
+    /**
+     * Returns an iterator over the elements in this map.
+     */
+    Iterator iterator() const {
+        return Iterator(this, first());
+    }
+
+    /**
+     * Returns an iterator that starts at the entry with the least key not
+     * less than key; hasNext() is false if there is none.
+     */
+    Iterator ceiling(const K &key) const {
+        return Iterator(this, lowerBound(key));
+    }
+
+    /**
+     * Returns an iterator that starts at the entry with the greatest key not
+     * greater than key; hasNext() is false if there is none.
+     */
+    Iterator floor(const K &key) const {
+        int k = upperBound(key);
+        return Iterator(this, k == 0 ? last() : predecessor(k));
+    }
+
+    /**
+     * Returns true if this map contains a mapping for the specified key.
+     */
+    bool containsKey(const K &key) const {
+        return indexOf(key) != 0;
+    }
+
+    /**
+     * Returns a const reference to the value to which the specified key is mapped.
+     * @throw ElementNotExist
+     */
+    const V &get(const K &key) const {
+        int k = indexOf(key);
+        if(k == 0) throw ElementNotExist();
+        return iValues[k];
+    }
+
+    /**
+     * Returns the entry mapped to key, or an empty Entry if the key is not
+     * present. Unlike get, a miss does not throw.
+     */
+    Entry find(const K &key) const {
+        int k = indexOf(key);
+        return k == 0 ? Entry() : Entry(iKeys[k], iValues[k]);
+    }
+
+    /**
+     * Copies the value mapped to key into value and returns true, or
+     * returns false and leaves value untouched if the key is not present.
+     */
+    bool tryGet(const K &key, V &value) const {
+        int k = indexOf(key);
+        if(k == 0) return false;
+        value = iValues[k];
+        return true;
+    }
+
+    /**
+     * Returns the value mapped to key, or defaultValue if the key is not present.
+     */
+    V getOrDefault(const K &key, const V &defaultValue) const {
+        int k = indexOf(key);
+        return k == 0 ? defaultValue : iValues[k];
+    }
+
+    /**
+     * Returns true if this map contains no key-value mappings.
+     */
+    bool isEmpty() const {
+        return !iSize;
+    }
+
+    /**
+     * Returns the number of key-value mappings in this map.
+     */
+    int size() const {
+        return iSize;
+    }
+};
+
+#endif
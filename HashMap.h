@@ -7,6 +7,7 @@
 using namespace std;
 
 #include "ElementNotExist.h"
+#include "NodePool.h"
 
 /**
  * HashMap is a map implemented by hashing. Also, the 'capacity' here means the
@@ -42,9 +43,22 @@ using namespace std;
  * function correctly, though the performance will be poor in this case.
  *
  * The order of iteration could be arbitary in HashMap. But it should be guaranteed
- * that each (key, value) pair be iterated exactly once.
+ * that each (key, value) pair be iterated exactly once. This implementation
+ * iterates in the order keys were first put: every node is also linked into a
+ * list in insertion order, so a full iteration costs O(size) no matter how
+ * many buckets there are, and putting an existing key keeps its position.
+ *
+ * The bucket array is allocated on the first put and its size is always a power
+ * of two. It doubles once the map holds more entries than buckets and halves when
+ * it falls below one eighth full. Resizing is incremental: a second table is
+ * allocated and every put and remove migrates a few buckets into it, so no
+ * single call pays for moving the whole map. Lookups never migrate: while a
+ * resize is in progress they search both tables, so a const HashMap may be
+ * read by several threads at once.
+ *
+ * Nodes come from Alloc, a NodePool of this map by default (see NodePool.h).
  */
-template <class K, class V, class H>
+template <class K, class V, class H, template<class> class Alloc = NodePool>
 class HashMap
 {
 public:
@@ -62,7 +76,7 @@ public:
         void setValue(const V& v){
             value = v;
         }
-        
+
         const K& getKey() const
         {
             return key;
@@ -77,43 +91,179 @@ public:
         struct Node{
             Entry data;
             Node* next;
-            Node():next(NULL){}
+            Node* before;
+            Node* after;
             Node(const K& key,const V& value)
-            :data(key,value),next(NULL){}
-        }**iHashTable;
-    
-        static const int iTableNum = 99971;
+            :data(key,value),next(NULL),before(NULL),after(NULL){}
+        };
+
+        typedef Alloc<Node> Pool;
+        Pool iPool;
+
+        static const int iMinTableNum = 8;
+        static const int iMaxTableNum = 1 << 30;
+        static const int iRehashStep = 4;
+
+        /**
+         * iHashTable[0] is the live table. While a resize is in progress
+         * iHashTable[1] is the table being filled and every bucket of
+         * iHashTable[0] below iRehashIndex has already been moved over.
+         */
+        Node **iHashTable[2];
+        int iTableNum[2];
+        int iRehashIndex;
+        Node *iFirst;
+        Node *iLast;
         int iSize;
-    
-        static int getTableNumber(const K& obj) {
-            int hash = H::hashCode(obj) % iTableNum;
-            if(hash < 0) hash += iTableNum;
+
+        static unsigned int hashOf(const K& obj) {
+            unsigned int hash = H::hashCode(obj);
+            hash ^= hash >> 16;
+            hash *= 0x45d9f3bU;
+            hash ^= hash >> 16;
             return hash;
         }
-    
+
+        static int getTableNumber(unsigned int hash, int tableNum) {
+            return hash & (tableNum - 1);
+        }
+
+        /**
+         * The least power of two not less than n, within the table limits.
+         */
+        static int roundUpTableNum(int n) {
+            int num = iMinTableNum;
+            while(num < n && num < iMaxTableNum) num <<= 1;
+            return num;
+        }
+
+        static Node** newTable(int num) {
+            Node **table = new Node*[num];
+            for(int i=0; i<num; ++i) table[i] = NULL;
+            return table;
+        }
+
+        bool isRehashing() const {
+            return iRehashIndex >= 0;
+        }
+
+        /**
+         * Moves up to n buckets from the old table into the new one and
+         * retires the old table once it is empty.
+         */
+        void rehash(int n) {
+            if(!isRehashing()) return;
+            while(n-- && iRehashIndex < iTableNum[0]){
+                for(Node *pos = iHashTable[0][iRehashIndex], *tmp; pos != NULL;){
+                    tmp = pos;
+                    pos = pos->next;
+                    int iTable = getTableNumber(hashOf(tmp->data.getKey()), iTableNum[1]);
+                    tmp->next = iHashTable[1][iTable];
+                    iHashTable[1][iTable] = tmp;
+                }
+                iHashTable[0][iRehashIndex++] = NULL;
+            }
+            if(iRehashIndex == iTableNum[0]){
+                delete[] iHashTable[0];
+                iHashTable[0] = iHashTable[1];
+                iTableNum[0] = iTableNum[1];
+                iHashTable[1] = NULL;
+                iTableNum[1] = 0;
+                iRehashIndex = -1;
+            }
+        }
+
+        void startRehash(int num) {
+            if(iTableNum[0] == 0){
+                iHashTable[0] = newTable(num);
+                iTableNum[0] = num;
+                return;
+            }
+            if(num == iTableNum[0]) return;
+            iHashTable[1] = newTable(num);
+            iTableNum[1] = num;
+            iRehashIndex = 0;
+        }
+
+        void finishRehash() {
+            if(isRehashing()) rehash(iTableNum[0]);
+        }
+
+        void checkGrow() {
+            if(isRehashing()) return;
+            if(iTableNum[0] == 0) startRehash(iMinTableNum);
+            else if(iSize > iTableNum[0] && iTableNum[0] < iMaxTableNum) startRehash(iTableNum[0] * 2);
+        }
+
+        void checkShrink() {
+            if(isRehashing() || iTableNum[0] <= iMinTableNum) return;
+            if(iSize < iTableNum[0] / 8) startRehash(roundUpTableNum(iSize * 2));
+        }
+
+        Node* findNode(const K& key, unsigned int hash) const {
+            for(int t = 0; t < 2; ++t){
+                if(iTableNum[t] == 0) continue;
+                for(Node *tmp = iHashTable[t][getTableNumber(hash, iTableNum[t])]; tmp != NULL; tmp = tmp->next){
+                    if(tmp->data.getKey() == key) return tmp;
+                }
+            }
+            return NULL;
+        }
+
+        Node* insertNode(const K& key, const V& value, unsigned int hash) {
+            checkGrow();
+            int t = isRehashing() ? 1 : 0;
+            int iTable = getTableNumber(hash, iTableNum[t]);
+            Node *data = newNode<Node>(iPool,key,value);
+            data->next = iHashTable[t][iTable];
+            iHashTable[t][iTable] = data;
+            data->before = iLast;
+            if(iLast != NULL) iLast->after = data;
+            else iFirst = data;
+            iLast = data;
+            ++iSize;
+            return data;
+        }
+
+        void releaseTables() {
+            if(!CanDropNodes<Node, Pool>::value){
+                for(Node *pos = iFirst, *tmp; pos != NULL;){
+                    tmp = pos;
+                    pos = pos->after;
+                    deleteNode(iPool,tmp);
+                }
+            }
+            iFirst = iLast = NULL;
+            iPool.releaseAll();
+            for(int t = 0; t < 2; ++t){
+                delete[] iHashTable[t];
+                iHashTable[t] = NULL;
+                iTableNum[t] = 0;
+            }
+            iRehashIndex = -1;
+            iSize = 0;
+        }
+
+        void copyFrom(const HashMap &x) {
+            reserve(x.iSize);
+            for(Node *tmp = x.iFirst; tmp != NULL; tmp = tmp->after)
+                put(tmp->data.getKey(), tmp->data.getValue());
+        }
+
 public:
     class Iterator
     {
     private:
-        const HashMap* pHashMap;
-        int iTable;
         Node* pNode;
     public:
         Iterator(const HashMap* parHashMap)
-            :pHashMap(parHashMap),iTable(0){
-            pNode = pHashMap->iHashTable[0];
-        }
+            :pNode(parHashMap->iFirst){}
 
         /**
          * TODO Returns true if the iteration has more elements.
          */
         bool hasNext() {
-            if(pNode->next != NULL) return true;
-            for (int i = iTable + 1; i < pHashMap->iTableNum; ++i)
-            {
-                if(pHashMap->iHashTable[i]->next != NULL) return true;
-            }
-            return false;
+            return pNode != NULL;
         }
 
         /**
@@ -121,39 +271,27 @@ public:
          * @throw ElementNotExist exception when hasNext() == false
          */
         const Entry &next() {
-            if(!hasNext()) throw ElementNotExist();
-            if(pNode->next != NULL){
-                pNode = pNode->next;
-                return pNode->data;
-            }
-            for( int i = iTable + 1; i < pHashMap->iTableNum; ++i )
-                if(pHashMap->iHashTable[i]->next != NULL){
-                    pNode = pHashMap->iHashTable[i]->next;
-                    iTable = i;
-                    return pNode->data;
-                }
+            if(pNode == NULL) throw ElementNotExist();
+            Node *tmp = pNode;
+            pNode = pNode->after;
+            return tmp->data;
         }
     };
-    
+
     /**
      * TODO Constructs an empty hash map.
      */
     HashMap()
-    :iSize(0){
-        iHashTable = new Node*[iTableNum];
-        for(int i=0; i<iTableNum; ++i){
-            iHashTable[i] = new Node;
-        }
+    :iRehashIndex(-1),iFirst(NULL),iLast(NULL),iSize(0){
+        iHashTable[0] = iHashTable[1] = NULL;
+        iTableNum[0] = iTableNum[1] = 0;
     }
 
     /**
      * TODO Destructor
      */
     ~HashMap() {
-        clear();
-        for( int i=0; i<iTableNum; ++i )
-            delete iHashTable[i];
-        delete[] iHashTable;
+        releaseTables();
     }
 
     /**
@@ -162,10 +300,7 @@ public:
     HashMap &operator=(const HashMap &x) {
         if(this == &x) return *this;
         clear();
-        for(Iterator itr = x.iterator(); itr.hasNext();){
-            Entry tmp = itr.next();
-            put(tmp.getKey(),tmp.getValue());
-        }
+        copyFrom(x);
         return *this;
     }
 
@@ -173,15 +308,10 @@ public:
      * TODO Copy-constructor
      */
     HashMap(const HashMap &x)
-    :iSize(0){
-        iHashTable = new Node*[iTableNum];
-        for(int i=0; i<iTableNum; ++i){
-            iHashTable[i] = new Node;
-        }
-        for(Iterator itr = x.iterator(); itr.hasNext();){
-            Entry tmp = itr.next();
-            put(tmp.getKey(),tmp.getValue());
-        }
+    :iRehashIndex(-1),iFirst(NULL),iLast(NULL),iSize(0){
+        iHashTable[0] = iHashTable[1] = NULL;
+        iTableNum[0] = iTableNum[1] = 0;
+        copyFrom(x);
     }
 
     /**
@@ -195,37 +325,36 @@ public:
      * TODO Removes all of the mappings from this map.
      */
     void clear() {
-        for(int i=0; i<iTableNum; ++i){
-            for(Node *pos = iHashTable[i]->next, *tmp; pos != NULL;)
-            {
-                tmp = pos;
-                pos = pos->next;
-                delete tmp;
-            }
-            iHashTable[i]->next = NULL;
-        }
-        iSize = 0;
+        releaseTables();
+    }
+
+    /**
+     * Makes room for at least n entries so that they can be put without
+     * any further resizing; tables stop growing at 2^30 buckets, so larger
+     * n reserve that many. Unlike put, this does not rehash incrementally:
+     * a resize in progress is finished, and the new table filled, before it
+     * returns, in O(n) for the one call.
+     */
+    void reserve(int n) {
+        finishRehash();
+        if(n <= iTableNum[0]) return;
+        startRehash(roundUpTableNum(n));
+        finishRehash();
     }
 
     /**
      * TODO Returns true if this map contains a mapping for the specified key.
      */
     bool containsKey(const K &key) const {
-        int iTable = getTableNumber(key);
-        for(Node *tmp = iHashTable[iTable]->next; tmp != NULL; tmp = tmp->next){
-            if(tmp->data.getKey() == key){
-                return true;
-            }
-        }
-        return false;
+        return findNode(key, hashOf(key)) != NULL;
     }
 
     /**
      * TODO Returns true if this map maps one or more keys to the specified value.
      */
     bool containsValue(const V &value) const {
-        for(Iterator itr = iterator(); itr.hasNext();){
-            if(itr.next().getValue() == value) return true;
+        for(Node *tmp = iFirst; tmp != NULL; tmp = tmp->after){
+            if(tmp->data.getValue() == value) return true;
         }
         return false;
     }
@@ -236,13 +365,37 @@ public:
      * @throw ElementNotExist
      */
     const V &get(const K &key) const {
-        int iTable = getTableNumber(key);
-        for(Node *tmp = iHashTable[iTable]->next; tmp != NULL; tmp = tmp->next){
-            if(tmp->data.getKey() == key){
-                return tmp->data.getValue();
-            }
-        }
-        throw ElementNotExist();
+        Node *tmp = findNode(key, hashOf(key));
+        if(tmp == NULL) throw ElementNotExist();
+        return tmp->data.getValue();
+    }
+
+    /**
+     * Returns the entry mapped to key, or NULL if the key is not present.
+     * Unlike get, a miss does not throw.
+     */
+    const Entry *find(const K &key) const {
+        Node *tmp = findNode(key, hashOf(key));
+        return tmp == NULL ? NULL : &tmp->data;
+    }
+
+    /**
+     * Copies the value mapped to key into value and returns true, or
+     * returns false and leaves value untouched if the key is not present.
+     */
+    bool tryGet(const K &key, V &value) const {
+        const Entry *tmp = find(key);
+        if(tmp == NULL) return false;
+        value = tmp->getValue();
+        return true;
+    }
+
+    /**
+     * Returns the value mapped to key, or defaultValue if the key is not present.
+     */
+    V getOrDefault(const K &key, const V &defaultValue) const {
+        const Entry *tmp = find(key);
+        return tmp == NULL ? defaultValue : tmp->getValue();
     }
 
     /**
@@ -256,17 +409,39 @@ public:
      * TODO Associates the specified value with the specified key in this map.
      */
     void put(const K &key, const V &value) {
-        int iTable = getTableNumber(key);
-        for(Node *tmp = iHashTable[iTable]->next; tmp != NULL; tmp = tmp->next){
-            if(tmp->data.getKey() == key){
-                tmp->data.setValue(value);
-                return;
-            }
+        rehash(iRehashStep);
+        unsigned int hash = hashOf(key);
+        Node *tmp = findNode(key, hash);
+        if(tmp != NULL){
+            tmp->data.setValue(value);
+            return;
         }
-        Node *data = new Node(key,value);
-        data->next = iHashTable[iTable]->next;
-        iHashTable[iTable]->next = data;
-        ++iSize;
+        insertNode(key, value, hash);
+    }
+
+    /**
+     * Associates the specified value with the specified key only if the key
+     * is not already mapped. Returns true if the value was put.
+     */
+    bool putIfAbsent(const K &key, const V &value) {
+        rehash(iRehashStep);
+        unsigned int hash = hashOf(key);
+        if(findNode(key, hash) != NULL) return false;
+        insertNode(key, value, hash);
+        return true;
+    }
+
+    /**
+     * Returns the value mapped to key, first mapping it to fn(key) if the
+     * key is absent. fn is only called when the key is absent.
+     */
+    template <class F>
+    const V &computeIfAbsent(const K &key, F fn) {
+        rehash(iRehashStep);
+        unsigned int hash = hashOf(key);
+        Node *tmp = findNode(key, hash);
+        if(tmp == NULL) tmp = insertNode(key, fn(key), hash);
+        return tmp->data.getValue();
     }
 
     /**
@@ -275,13 +450,23 @@ public:
      * @throw ElementNotExist
      */
     void remove(const K &key) {
-        int iTable = getTableNumber(key);
-        for(Node *pos = iHashTable[iTable]->next, *tmp = iHashTable[iTable]; pos != NULL; tmp = pos, pos = pos->next){
-            if(pos->data.getKey() == key){
-                tmp->next = pos->next;
-                delete pos;
-                --iSize;
-                return;
+        rehash(iRehashStep);
+        unsigned int hash = hashOf(key);
+        for(int t = 0; t < 2; ++t){
+            if(iTableNum[t] == 0) continue;
+            for(Node **pos = &iHashTable[t][getTableNumber(hash, iTableNum[t])]; *pos != NULL; pos = &(*pos)->next){
+                if((*pos)->data.getKey() == key){
+                    Node *tmp = *pos;
+                    *pos = tmp->next;
+                    if(tmp->before != NULL) tmp->before->after = tmp->after;
+                    else iFirst = tmp->after;
+                    if(tmp->after != NULL) tmp->after->before = tmp->before;
+                    else iLast = tmp->before;
+                    deleteNode(iPool,tmp);
+                    --iSize;
+                    checkShrink();
+                    return;
+                }
             }
         }
         throw ElementNotExist();
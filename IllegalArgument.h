@@ -0,0 +1,19 @@
+/** @file IllegalArgument.h
+ * Thrown when a method is passed an argument it cannot work with.
+ * For example, list.setGrowthFactor(1.0) raises this exception.
+ */
+
+#include <string>
+
+#ifndef __ILLEGALARGUMENT_H
+#define __ILLEGALARGUMENT_H
+
+class IllegalArgument {
+public:
+    IllegalArgument() {}
+    IllegalArgument(std::string msg) : msg(msg) {}
+    std::string getMessage() const { return msg; }
+private:
+    std::string msg;
+};
+#endif
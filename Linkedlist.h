@@ -4,13 +4,16 @@
 
 #include "IndexOutOfBound.h"
 #include "ElementNotExist.h"
+#include "NodePool.h"
 
 /**
  * A linked list.
  *
+ * Nodes come from Alloc, a NodePool of this list by default (see NodePool.h).
+ *
  * The iterator iterates in the order of the elements being loaded into this list.
  */
-template <class T>
+template <class T, template<class> class Alloc = NodePool>
 class LinkedList
 {
     struct Node{
@@ -25,11 +28,13 @@ class LinkedList
         }
     };
 private:
+    typedef Alloc<Node> Pool;
+    Pool iPool;
     Node *head;
     int iSize;
     Node* add(Node *parNode, const T& parData){
         ++iSize;
-        Node *tmp = new Node(parData,parNode,parNode->next);
+        Node *tmp = newNode<Node>(iPool,parData,parNode,parNode->next);
         tmp->next->pre = tmp;
         tmp->pre->next = tmp;
         return tmp;
@@ -39,7 +44,7 @@ private:
         parNode->next->pre = parNode->pre;
         parNode->pre->next = parNode->next;
         Node *tmp = parNode->next;
-        delete parNode;
+        deleteNode(iPool,parNode);
         return tmp;
     }
 public:
@@ -97,7 +102,7 @@ public:
     /**
      * TODO Copy constructor
      */
-    LinkedList(const LinkedList<T> &c)
+    LinkedList(const LinkedList &c)
     :iSize(0) {
         head = new Node;
         for(Node *tmp = c.head->next; tmp != c.head; tmp = tmp->next){
@@ -107,7 +112,7 @@ public:
     /**
      * TODO Assignment operator
      */
-    LinkedList<T>& operator=(const LinkedList<T> &c) {
+    LinkedList& operator=(const LinkedList &c) {
         if(this == &c) return *this;
         clear();
         for(Node *tmp = c.head->next; tmp != c.head; tmp = tmp->next){
@@ -162,11 +167,18 @@ public:
     }
     
     /**
-     * Removes all of the elements from this list.
+     * Removes all of the elements from this list. With the default pool and
+     * trivially destructible elements the nodes are dropped with their
+     * slabs instead of one by one.
      */
     void clear() {
-        while(head->next != head)
+        if(CanDropNodes<Node, Pool>::value){
+            head->next = head->pre = head;
+            iSize = 0;
+        }
+        else while(head->next != head)
             remove(head->next);
+        iPool.releaseAll();
     }
     
     /**
@@ -211,6 +223,50 @@ public:
         return head->pre->data;
     }
     
+    /**
+     *  Copies the element at the specified position into element and returns true,
+     * or returns false and leaves element untouched if the index is out of range.
+     */
+    bool tryGet(int index, T& element) const {
+        if(index < 0 || index >= iSize) return false;
+        Node *tmp = head->next;
+        while(index--){
+            tmp = tmp->next;
+        }
+        element = tmp->data;
+        return true;
+    }
+
+    /**
+     *  Returns the element at the specified position, or defaultValue if the
+     * index is out of range.
+     */
+    T getOrDefault(int index, const T& defaultValue) const {
+        T element(defaultValue);
+        tryGet(index, element);
+        return element;
+    }
+
+    /**
+     *  Copies the first element into element and returns true,
+     * or returns false if this list is empty.
+     */
+    bool tryGetFirst(T& element) const {
+        if(!iSize) return false;
+        element = head->next->data;
+        return true;
+    }
+
+    /**
+     *  Copies the last element into element and returns true,
+     * or returns false if this list is empty.
+     */
+    bool tryGetLast(T& element) const {
+        if(!iSize) return false;
+        element = head->pre->data;
+        return true;
+    }
+
     /**
      *  Returns true if this list contains no elements.
      */
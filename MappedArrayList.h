@@ -0,0 +1,466 @@
+/** @file */
+#ifndef __MAPPEDARRAYLIST_H
+#define __MAPPEDARRAYLIST_H
+
+#include <cerrno>
+#include <climits>
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <stdint.h>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "IndexOutOfBound.h"
+#include "ElementNotExist.h"
+#include "FileAccessError.h"
+
+/**
+ * MappedArrayList is an ArrayList of trivially copyable elements kept in a
+ * memory-mapped file, so opening even a very large list only maps it: pages
+ * are read in when first touched, and a list opened read-only by several
+ * processes shares their page cache.
+ *
+ * The file is a 64-byte header followed by the elements in native byte
+ * order. The header holds a magic string, the format version, sizeof(T)
+ * and the number of elements; the rest of the file is capacity. When it is
+ * full the file is doubled with ftruncate and remapped with mremap where
+ * available. Changes reach the file through the page cache; sync() waits
+ * until they are on disk.
+ *
+ * Every method that changes the list throws FileAccessError on a list
+ * opened read-only.
+ *
+ * The iterator iterates in the order of the elements being loaded into this list
+ */
+template<class T>
+class MappedArrayList
+{
+    static_assert(std::is_trivially_copyable<T>::value, "MappedArrayList needs a trivially copyable element type");
+    static_assert(alignof(T) <= 64, "MappedArrayList elements must fit the alignment of the header");
+
+private:
+    struct Header{
+        char magic[8];
+        uint32_t version;
+        uint32_t elementSize;
+        uint64_t size;
+        char reserved[40];
+    };
+    static_assert(sizeof(Header) == 64, "the header takes exactly 64 bytes");
+
+    static const uint32_t iVersion = 1;
+    static const int iInitialCapacity = 1024;
+
+    int iFd;
+    bool iReadOnly;
+    char *pMap;
+    size_t iMapLength;
+    int iCapacity;
+    std::string iPath;
+
+    static const char *magic(){
+        return "DSWALST";
+    }
+
+    Header *header() const{
+        return reinterpret_cast<Header*>(pMap);
+    }
+
+    T *data() const{
+        return reinterpret_cast<T*>(pMap + sizeof(Header));
+    }
+
+    int sizeOf() const{
+        return static_cast<int>(header()->size);
+    }
+
+    void fail(const char *what) const{
+        throw FileAccessError(std::string(what) + " " + iPath + ": " + strerror(errno));
+    }
+
+    void checkWritable() const{
+        if(iReadOnly) throw FileAccessError("read-only list " + iPath);
+    }
+
+    static size_t bytesFor(int capacity){
+        return sizeof(Header) + static_cast<size_t>(capacity) * sizeof(T);
+    }
+
+    void unmap(){
+        if(pMap != NULL) munmap(pMap, iMapLength);
+        if(iFd >= 0) close(iFd);
+        pMap = NULL;
+        iFd = -1;
+    }
+
+    /**
+     * Resizes the file to hold capacity elements and maps it again.
+     */
+    void remap(int capacity){
+        size_t length = bytesFor(capacity);
+        if(ftruncate(iFd, static_cast<off_t>(length)) != 0) fail("cannot resize");
+#ifdef MREMAP_MAYMOVE
+        void *map = mremap(pMap, iMapLength, length, MREMAP_MAYMOVE);
+        if(map == MAP_FAILED) fail("cannot remap");
+#else
+        void *map = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, iFd, 0);
+        if(map == MAP_FAILED) fail("cannot remap");
+        munmap(pMap, iMapLength);
+#endif
+        pMap = static_cast<char*>(map);
+        iMapLength = length;
+        iCapacity = capacity;
+    }
+
+    void ensureCapacity(int n){
+        if(n <= iCapacity) return;
+        int capacity = iCapacity == 0 ? iInitialCapacity : (iCapacity > INT_MAX / 2 ? INT_MAX : iCapacity * 2);
+        remap(capacity > n ? capacity : n);
+    }
+
+    void openFile(){
+        iFd = open(iPath.c_str(), iReadOnly ? O_RDONLY : O_RDWR | O_CREAT, 0644);
+        if(iFd < 0) fail("cannot open");
+        struct stat st;
+        if(fstat(iFd, &st) != 0) fail("cannot stat");
+        size_t length = static_cast<size_t>(st.st_size);
+        bool fresh = length == 0 && !iReadOnly;
+        if(fresh){
+            length = sizeof(Header);
+            if(ftruncate(iFd, static_cast<off_t>(length)) != 0) fail("cannot resize");
+        }
+        if(length < sizeof(Header)) throw FileAccessError("not a MappedArrayList file " + iPath);
+        void *map = mmap(NULL, length, iReadOnly ? PROT_READ : PROT_READ | PROT_WRITE, MAP_SHARED, iFd, 0);
+        if(map == MAP_FAILED) fail("cannot map");
+        pMap = static_cast<char*>(map);
+        iMapLength = length;
+        if(fresh){
+            memcpy(header()->magic, magic(), sizeof(header()->magic));
+            header()->version = iVersion;
+            header()->elementSize = sizeof(T);
+            header()->size = 0;
+        }
+        const Header *h = header();
+        if(memcmp(h->magic, magic(), sizeof(h->magic)) != 0 || h->version != iVersion || h->elementSize != sizeof(T))
+            throw FileAccessError("not a MappedArrayList file of this element type " + iPath);
+        uint64_t capacity = (length - sizeof(Header)) / sizeof(T);
+        if(h->size > capacity || capacity > static_cast<uint64_t>(INT_MAX))
+            throw FileAccessError("corrupt or too large MappedArrayList file " + iPath);
+        iCapacity = static_cast<int>(capacity);
+    }
+
+public:
+    class Iterator
+    {
+    private:
+        int position;
+        MappedArrayList *pArray;
+        bool ifPointed;
+    public:
+        Iterator(MappedArrayList *parArray)
+        :position(0),pArray(parArray),ifPointed(false){}
+        /**
+         * Returns true if the iteration has more elements.
+         */
+        bool hasNext() {
+            int size = pArray->size();
+            if(position < size - 1) return true;
+            if((!ifPointed) && (position == size - 1)) return true;
+            return false;
+        }
+
+        /**
+         * Returns the next element in the iteration.
+         * @throw ElementNotExist exception when hasNext() == false
+         */
+        const T &next() {
+            if(!hasNext()) throw ElementNotExist();
+            if(ifPointed) ++position;
+            else ifPointed = true;
+            return pArray->data()[position];
+        }
+
+        /**
+         * Removes from the underlying collection the last element returned
+         * by the iterator.
+         * @throw ElementNotExist
+         */
+        void remove() {
+            if(!ifPointed) throw ElementNotExist();
+            pArray->removeIndex(position);
+            ifPointed = false;
+        }
+    };
+
+    /**
+     *  Opens the list stored in the file at path. A missing or empty file
+     * becomes an empty list, unless readOnly is set.
+     * @throw FileAccessError if the file cannot be opened or mapped, or holds
+     * something else than a list of this element type
+     */
+    explicit MappedArrayList(const std::string& path, bool readOnly = false)
+    :iFd(-1),iReadOnly(readOnly),pMap(NULL),iMapLength(0),iCapacity(0),iPath(path) {
+        try{
+            openFile();
+        }
+        catch(...){
+            unmap();
+            throw;
+        }
+    }
+
+    MappedArrayList(const MappedArrayList&) = delete;
+    MappedArrayList& operator=(const MappedArrayList&) = delete;
+
+    /**
+     *  Move-constructor. x is left closed and must not be used, other than
+     * being destroyed or assigned to.
+     */
+    MappedArrayList(MappedArrayList&& x) noexcept
+    :iFd(x.iFd),iReadOnly(x.iReadOnly),pMap(x.pMap),iMapLength(x.iMapLength),iCapacity(x.iCapacity),iPath(std::move(x.iPath)) {
+        x.iFd = -1;
+        x.pMap = NULL;
+        x.iCapacity = 0;
+    }
+
+    /**
+     *  Move assignment operator. This list is closed first.
+     */
+    MappedArrayList& operator=(MappedArrayList&& x) noexcept {
+        if(this == &x) return *this;
+        unmap();
+        std::swap(iFd, x.iFd);
+        std::swap(pMap, x.pMap);
+        iReadOnly = x.iReadOnly;
+        iMapLength = x.iMapLength;
+        iCapacity = x.iCapacity;
+        iPath = std::move(x.iPath);
+        x.iCapacity = 0;
+        return *this;
+    }
+
+    /**
+     *  Destructor. Unmaps the file without waiting for it to reach the disk.
+     */
+    ~MappedArrayList() {
+        unmap();
+    }
+
+    /**
+     *  Returns true if the list was opened read-only.
+     */
+    bool isReadOnly() const {
+        return iReadOnly;
+    }
+
+    /**
+     *  Writes the changes made so far to the disk and waits for them.
+     * @throw FileAccessError
+     */
+    void sync() {
+        if(!iReadOnly && msync(pMap, iMapLength, MS_SYNC) != 0) fail("cannot sync");
+    }
+
+    /**
+     *  Appends the specified element to the end of this list.
+     * Always returns true.
+     * @throw FileAccessError
+     */
+    bool add(const T& e) {
+        checkWritable();
+        int n = sizeOf();
+        T tmp = e;
+        ensureCapacity(n + 1);
+        data()[n] = tmp;
+        header()->size = n + 1;
+        return true;
+    }
+
+    /**
+     *  Appends the elements in [begin, end) to the end of this list.
+     * @throw FileAccessError
+     */
+    template<class Iter>
+    void addAll(Iter begin, Iter end) {
+        for(; begin != end; ++begin) add(*begin);
+    }
+
+    /**
+     *  Appends the n elements starting at p with a single copy. p may point
+     * into this list: growing may move the mapping, so p is rebased after it.
+     * @throw IndexOutOfBound if the list would exceed INT_MAX elements
+     * @throw FileAccessError
+     */
+    void addAll(const T *p, int n) {
+        checkWritable();
+        int size = sizeOf();
+        if(n <= 0) return;
+        if(n > INT_MAX - size) throw IndexOutOfBound();
+        std::less<const T*> before;
+        bool inside = !before(p, data()) && before(p, data() + iCapacity);
+        ptrdiff_t offset = inside ? p - data() : 0;
+        ensureCapacity(size + n);
+        if(inside) p = data() + offset;
+        memcpy(static_cast<void*>(data() + size), static_cast<const void*>(p), n * sizeof(T));
+        header()->size = size + n;
+    }
+
+    /**
+     *  Inserts the specified element to the specified position in this list.
+     * The range of index parameter is [0, size].
+     * @throw IndexOutOfBound
+     * @throw FileAccessError
+     */
+    void add(int index, const T& element) {
+        checkWritable();
+        int n = sizeOf();
+        if(index < 0 || index > n) throw IndexOutOfBound();
+        T tmp = element;
+        ensureCapacity(n + 1);
+        memmove(static_cast<void*>(data() + index + 1), static_cast<const void*>(data() + index), (n - index) * sizeof(T));
+        data()[index] = tmp;
+        header()->size = n + 1;
+    }
+
+    /**
+     *  Removes all of the elements from this list. The file keeps its size.
+     * @throw FileAccessError
+     */
+    void clear() {
+        checkWritable();
+        header()->size = 0;
+    }
+
+    /**
+     *  Returns true if this list contains the specified element.
+     */
+    bool contains(const T& e) const {
+        return indexOf(e) >= 0;
+    }
+
+    /**
+     *  Returns the index of the first occurrence of the specified element, or -1.
+     */
+    int indexOf(const T& e) const {
+        const T *p = data();
+        for(int i=0, n=sizeOf(); i<n; ++i)
+            if(p[i] == e)
+                return i;
+        return -1;
+    }
+
+    /**
+     *  Returns a const reference to the element at the specified position in this list.
+     * The index is zero-based, with range [0, size). The reference is
+     * invalidated when the list grows.
+     * @throw IndexOutOfBound
+     */
+    const T& get(int index) const {
+        if(index < 0 || index >= sizeOf()) throw IndexOutOfBound();
+        return data()[index];
+    }
+
+    /**
+     *  Copies the element at the specified position into element and returns true,
+     * or returns false and leaves element untouched if the index is out of range.
+     */
+    bool tryGet(int index, T& element) const {
+        if(index < 0 || index >= sizeOf()) return false;
+        element = data()[index];
+        return true;
+    }
+
+    /**
+     *  Returns true if this list contains no elements.
+     */
+    bool isEmpty() const {
+        return sizeOf() == 0;
+    }
+
+    /**
+     *  Removes the element at the specified position in this list.
+     * The index is zero-based, with range [0, size).
+     * @throw IndexOutOfBound
+     * @throw FileAccessError
+     */
+    void removeIndex(int index) {
+        checkWritable();
+        int n = sizeOf();
+        if(index < 0 || index >= n) throw IndexOutOfBound();
+        memmove(static_cast<void*>(data() + index), static_cast<const void*>(data() + index + 1), (n - index - 1) * sizeof(T));
+        header()->size = n - 1;
+    }
+
+    /**
+     *  Removes the first occurrence of the specified element from this list, if it is present.
+     * Returns true if it was present in the list, otherwise false.
+     * @throw FileAccessError
+     */
+    bool remove(const T &e) {
+        checkWritable();
+        int p = indexOf(e);
+        if(p < 0) return false;
+        removeIndex(p);
+        return true;
+    }
+
+    /**
+     *  Replaces the element at the specified position in this list with the specified element.
+     * The index is zero-based, with range [0, size).
+     * @throw IndexOutOfBound
+     * @throw FileAccessError
+     */
+    void set(int index, const T &element) {
+        checkWritable();
+        if(index < 0 || index >= sizeOf()) throw IndexOutOfBound();
+        data()[index] = element;
+    }
+
+    /**
+     *  Returns the number of elements in this list.
+     */
+    int size() const {
+        return pMap != NULL ? sizeOf() : 0;
+    }
+
+    /**
+     *  Returns the number of elements the file has room for.
+     */
+    int capacity() const {
+        return iCapacity;
+    }
+
+    /**
+     *  Grows the file to hold at least n elements.
+     * @throw FileAccessError
+     */
+    void reserve(int n) {
+        checkWritable();
+        if(n > iCapacity) remap(n);
+    }
+
+    /**
+     *  Truncates the file to the elements it holds.
+     * @throw FileAccessError
+     */
+    void shrinkToFit() {
+        checkWritable();
+        if(sizeOf() < iCapacity) remap(sizeOf());
+    }
+
+    /**
+     *  Returns an iterator over the elements in this list.
+     */
+    Iterator iterator() {
+        return Iterator(this);
+    }
+};
+
+#endif
@@ -0,0 +1,376 @@
+/** @file NodePool.h
+ * Node allocators for LinkedList, HashMap and TreeMap.
+ *
+ * A node allocator is a class template over the node type, so that a
+ * container can name it before its node type is complete, with
+ *
+ *  - void *allocate(), storage for one node;
+ *  - void deallocate(void *p), taking back the storage of a destroyed node;
+ *  - void releaseAll(), called once every node has been destroyed;
+ *  - void adopt(Alloc &x), taking over every node allocated from x;
+ *  - void share(Alloc &x), keeping the nodes x has handed out alive for as
+ *    long as this allocator, so that they may move to its container;
+ *  - ownsNodes, true if releaseAll() frees the storage of all the nodes,
+ *    so that nodes need not be deallocated one by one before it.
+ *
+ * Allocators are default constructible and movable, and a moved-to
+ * allocator takes over the nodes of the other. A container never copies
+ * its allocator: a copy of the container gets a fresh one.
+ */
+#ifndef __NODEPOOL_H
+#define __NODEPOOL_H
+
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+/**
+ * The default allocator: a free list over slabs owned by one container.
+ * Slabs start at 16 nodes and double up to 4096, so small containers stay
+ * small. releaseAll() frees the slabs, in O(slabs). A NodePool must only be
+ * used by one thread at a time, like the container that owns it.
+ *
+ * Pools that share() slabs hold them through a reference count, and a
+ * shared slab is freed when the last pool holding it is released, so the
+ * memory of a container split in two is returned once both halves are.
+ */
+template<class Node>
+class NodePool
+{
+public:
+    static const bool ownsNodes = true;
+
+private:
+    union Slot{
+        Slot *next;
+        typename std::aligned_storage<sizeof(Node), alignof(Node)>::type node;
+    };
+
+    static const int iFirstSlab = 16;
+    static const int iMaxSlab = 4096;
+
+    /**
+     * Slabs shared by several pools, freed by the last of them.
+     */
+    struct Shared{
+        std::atomic<int> refs;
+        Slot *slabs;
+        Shared(Slot *parSlabs)
+        :refs(1),slabs(parSlabs){}
+    };
+
+    struct Hold{
+        Shared *shared;
+        Hold *next;
+    };
+
+    /**
+     * The newest slab; the first slot of every slab links to the one
+     * allocated before it, and the others hold nodes.
+     */
+    Slot *pSlabs;
+    Slot *pFree;
+    Slot *pNext;
+    Slot *pEnd;
+    Hold *pHolds;
+    int iSlabSize;
+
+    static void freeSlabs(Slot *slabs){
+        while(slabs != NULL){
+            Slot *tmp = slabs;
+            slabs = tmp->next;
+            ::operator delete(tmp);
+        }
+    }
+
+    void hold(Shared *shared){
+        Hold *tmp = new Hold;
+        tmp->shared = shared;
+        tmp->next = pHolds;
+        pHolds = tmp;
+    }
+
+    void grow(){
+        Slot *slab = static_cast<Slot*>(::operator new(sizeof(Slot) * (iSlabSize + 1)));
+        slab->next = pSlabs;
+        pSlabs = slab;
+        pNext = slab + 1;
+        pEnd = pNext + iSlabSize;
+        if(iSlabSize < iMaxSlab) iSlabSize *= 2;
+    }
+
+    void reset(){
+        pSlabs = pFree = pNext = pEnd = NULL;
+        pHolds = NULL;
+        iSlabSize = iFirstSlab;
+    }
+
+public:
+    NodePool(){
+        reset();
+    }
+
+    NodePool(const NodePool&) = delete;
+    NodePool& operator=(const NodePool&) = delete;
+
+    NodePool(NodePool&& x) noexcept
+    :pSlabs(x.pSlabs),pFree(x.pFree),pNext(x.pNext),pEnd(x.pEnd),pHolds(x.pHolds),iSlabSize(x.iSlabSize) {
+        x.reset();
+    }
+
+    NodePool& operator=(NodePool&& x) noexcept {
+        if(this == &x) return *this;
+        releaseAll();
+        pSlabs = x.pSlabs;
+        pFree = x.pFree;
+        pNext = x.pNext;
+        pEnd = x.pEnd;
+        pHolds = x.pHolds;
+        iSlabSize = x.iSlabSize;
+        x.reset();
+        return *this;
+    }
+
+    ~NodePool(){
+        releaseAll();
+    }
+
+    void *allocate(){
+        if(pFree != NULL){
+            Slot *tmp = pFree;
+            pFree = tmp->next;
+            return tmp;
+        }
+        if(pNext == pEnd) grow();
+        return pNext++;
+    }
+
+    void deallocate(void *p){
+        Slot *tmp = static_cast<Slot*>(p);
+        tmp->next = pFree;
+        pFree = tmp;
+    }
+
+    void releaseAll(){
+        freeSlabs(pSlabs);
+        while(pHolds != NULL){
+            Hold *tmp = pHolds;
+            pHolds = tmp->next;
+            if(tmp->shared->refs.fetch_sub(1, std::memory_order_acq_rel) == 1){
+                freeSlabs(tmp->shared->slabs);
+                delete tmp->shared;
+            }
+            delete tmp;
+        }
+        reset();
+    }
+
+    /**
+     * Takes over the slabs of x, with its free and unused slots, in
+     * O(slabs + free slots) of x.
+     */
+    void adopt(NodePool& x){
+        if(this == &x) return;
+        for(; x.pNext != x.pEnd; ++x.pNext) x.deallocate(x.pNext);
+        if(x.pFree != NULL){
+            Slot *tail = x.pFree;
+            while(tail->next != NULL) tail = tail->next;
+            tail->next = pFree;
+            pFree = x.pFree;
+        }
+        if(x.pSlabs != NULL){
+            Slot *tail = x.pSlabs;
+            while(tail->next != NULL) tail = tail->next;
+            tail->next = pSlabs;
+            pSlabs = x.pSlabs;
+        }
+        if(x.pHolds != NULL){
+            Hold *tail = x.pHolds;
+            while(tail->next != NULL) tail = tail->next;
+            tail->next = pHolds;
+            pHolds = x.pHolds;
+        }
+        x.reset();
+    }
+
+    /**
+     * Makes every slab of x shared with this pool, in O(1 + slabs shared
+     * by x already). Both pools keep allocating from their own free slots.
+     */
+    void share(NodePool& x){
+        if(this == &x) return;
+        if(x.pSlabs != NULL){
+            Shared *shared = new Shared(x.pSlabs);
+            try{
+                x.hold(shared);
+            }
+            catch(...){
+                delete shared;
+                throw;
+            }
+            x.pSlabs = NULL;
+        }
+        for(Hold *tmp = x.pHolds; tmp != NULL; tmp = tmp->next){
+            hold(tmp->shared);
+            tmp->shared->refs.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+};
+
+/**
+ * A NodePool per thread, shared by every container of the same node type
+ * on that thread, so that nodes freed by one container are reused by the
+ * next. Nodes may be freed on another thread than the one that allocated
+ * them. The slabs are never returned to the system: when a thread exits,
+ * its slabs and free nodes go to a process-wide depot, which the next new
+ * thread takes over.
+ */
+template<class Node>
+class ThreadLocalNodePool
+{
+public:
+    static const bool ownsNodes = false;
+
+private:
+    struct Depot{
+        std::mutex lock;
+        NodePool<Node> pool;
+    };
+
+    /**
+     * Never destroyed, since containers with static storage may still free
+     * nodes into it while the program exits.
+     */
+    static Depot& depot(){
+        static Depot *instance = new Depot;
+        return *instance;
+    }
+
+    struct Cache{
+        NodePool<Node> pool;
+        Cache(){
+            Depot &d = depot();
+            std::lock_guard<std::mutex> guard(d.lock);
+            pool.adopt(d.pool);
+            current() = &pool;
+        }
+        ~Cache(){
+            current() = NULL;
+            exited() = true;
+            Depot &d = depot();
+            std::lock_guard<std::mutex> guard(d.lock);
+            d.pool.adopt(pool);
+        }
+    };
+
+    static NodePool<Node>*& current(){
+        static thread_local NodePool<Node> *pool = NULL;
+        return pool;
+    }
+
+    static bool& exited(){
+        static thread_local bool flag = false;
+        return flag;
+    }
+
+    /**
+     * The pool of the calling thread, or NULL once the thread is exiting.
+     */
+    static NodePool<Node>* local(){
+        NodePool<Node> *pool = current();
+        if(pool == NULL && !exited()){
+            static thread_local Cache cache;
+            pool = current();
+        }
+        return pool;
+    }
+
+public:
+    void *allocate(){
+        NodePool<Node> *pool = local();
+        if(pool != NULL) return pool->allocate();
+        Depot &d = depot();
+        std::lock_guard<std::mutex> guard(d.lock);
+        return d.pool.allocate();
+    }
+
+    void deallocate(void *p){
+        NodePool<Node> *pool = local();
+        if(pool != NULL){
+            pool->deallocate(p);
+            return;
+        }
+        Depot &d = depot();
+        std::lock_guard<std::mutex> guard(d.lock);
+        d.pool.deallocate(p);
+    }
+
+    void releaseAll(){}
+
+    void adopt(ThreadLocalNodePool&){}
+
+    void share(ThreadLocalNodePool&){}
+};
+
+/**
+ * One operator new per node, as the containers did before they took an
+ * allocator.
+ */
+template<class Node>
+class HeapNodeAllocator
+{
+public:
+    static const bool ownsNodes = false;
+
+    void *allocate(){
+        return ::operator new(sizeof(Node));
+    }
+
+    void deallocate(void *p){
+        ::operator delete(p);
+    }
+
+    void releaseAll(){}
+
+    void adopt(HeapNodeAllocator&){}
+
+    void share(HeapNodeAllocator&){}
+};
+
+/**
+ * Constructs a Node from args in storage from pool.
+ */
+template<class Node, class Pool, class... Args>
+Node* newNode(Pool& pool, Args&&... args){
+    void *p = pool.allocate();
+    try{
+        return new(p) Node(std::forward<Args>(args)...);
+    }
+    catch(...){
+        pool.deallocate(p);
+        throw;
+    }
+}
+
+/**
+ * Destroys node, if not NULL, and gives its storage back to pool.
+ */
+template<class Node, class Pool>
+void deleteNode(Pool& pool, Node *node){
+    if(node == NULL) return;
+    node->~Node();
+    pool.deallocate(node);
+}
+
+/**
+ * True if a container may drop all its nodes with pool.releaseAll() alone:
+ * the pool frees them and they have nothing to destroy.
+ */
+template<class Node, class Pool>
+struct CanDropNodes : std::integral_constant<bool, Pool::ownsNodes && std::is_trivially_destructible<Node>::value>
+{
+};
+
+#endif
@@ -0,0 +1,204 @@
+/** @file */
+#ifndef __PARALLELSORT_H
+#define __PARALLELSORT_H
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <thread>
+#include <type_traits>
+
+/**
+ * ParallelSort<T> sorts a plain array of n constructed elements with up to
+ * threads threads, the way TreeMap runs its set operations: each step
+ * splits the work in two and hands the lower half to another thread while
+ * the thread budget lasts. The comparator must not throw.
+ */
+template<class T>
+struct ParallelSort
+{
+    /**
+     * True if sortRadix can be used, that is for integral types other than bool.
+     */
+    static const bool radix = std::is_integral<T>::value && !std::is_same<T, bool>::value;
+
+    /**
+     * Stable merge sort. Both halves are sorted in parallel, and then
+     * merged in parallel by cutting the larger run at its middle element,
+     * finding where that element goes in the other run and rotating the
+     * pieces between, which leaves two independent merges.
+     */
+    template<class Compare>
+    static void mergeSort(T *p, int n, Compare cmp, int threads){
+        if(threads <= 1 || n < iParallelCutoff){
+            std::stable_sort(p, p + n, cmp);
+            return;
+        }
+        int mid = n / 2;
+        std::thread worker([&]{ mergeSort(p, mid, cmp, threads / 2); });
+        mergeSort(p + mid, n - mid, cmp, threads - threads / 2);
+        worker.join();
+        merge(p, mid, n, cmp, threads);
+    }
+
+    /**
+     * Stable least significant digit radix sort into ascending order, one
+     * byte per pass. Each thread counts the digits of its own slice and
+     * scatters that slice to its share of every bucket, so the passes keep
+     * the order of equal digits. Passes where all keys share the digit are
+     * skipped.
+     */
+    static void sortRadix(T *p, int n, int threads){
+        if(n < iRadixCutoff){
+            std::sort(p, p + n);
+            return;
+        }
+        if(threads > n / iRadixSlice) threads = n / iRadixSlice;
+        if(threads < 1) threads = 1;
+        T *buf = static_cast<T*>(malloc(n * sizeof(T)));
+        int *counts = static_cast<int*>(malloc(threads * kBuckets * sizeof(int)));
+        if(buf == NULL || counts == NULL){
+            free(buf);
+            free(counts);
+            throw std::bad_alloc();
+        }
+        T *src = p, *dst = buf;
+        for(int shift = 0; shift < static_cast<int>(sizeof(T)) * 8; shift += 8){
+            Histogram histogram = {src, n, threads, shift, counts};
+            forEach(0, threads, histogram);
+            if(!offsets(counts, threads, n)) continue;
+            Scatter scatter = {src, dst, n, threads, shift, counts};
+            forEach(0, threads, scatter);
+            std::swap(src, dst);
+        }
+        if(src != p) memcpy(p, src, n * sizeof(T));
+        free(buf);
+        free(counts);
+    }
+
+private:
+    /**
+     * Runs below this many elements never go to another thread.
+     */
+    static const int iParallelCutoff = 1 << 15;
+
+    /**
+     * Below this many elements radix sort is not worth its buffer.
+     */
+    static const int iRadixCutoff = 1 << 10;
+
+    /**
+     * Every radix sort thread gets a slice of at least this many elements.
+     */
+    static const int iRadixSlice = 1 << 16;
+
+    static const int kBuckets = 256;
+
+    typedef typename std::make_unsigned<typename std::conditional<radix, T, int>::type>::type Bits;
+
+    /**
+     * The digit of x at shift, with the sign bit flipped so that negative
+     * numbers come first.
+     */
+    static int digit(T x, int shift){
+        Bits bits = static_cast<Bits>(x);
+        if(std::is_signed<T>::value) bits ^= static_cast<Bits>(Bits(1) << (sizeof(T) * 8 - 1));
+        return static_cast<int>((bits >> shift) & (kBuckets - 1));
+    }
+
+    static int sliceBegin(int n, int threads, int t){
+        return static_cast<int>(static_cast<long long>(n) * t / threads);
+    }
+
+    struct Histogram{
+        const T *src;
+        int n, threads, shift;
+        int *counts;
+        void operator()(int t) const{
+            int *c = counts + t * kBuckets;
+            std::fill(c, c + kBuckets, 0);
+            for(int i = sliceBegin(n, threads, t), e = sliceBegin(n, threads, t + 1); i < e; ++i)
+                ++c[digit(src[i], shift)];
+        }
+    };
+
+    struct Scatter{
+        const T *src;
+        T *dst;
+        int n, threads, shift;
+        int *counts;
+        void operator()(int t) const{
+            int *c = counts + t * kBuckets;
+            for(int i = sliceBegin(n, threads, t), e = sliceBegin(n, threads, t + 1); i < e; ++i)
+                dst[c[digit(src[i], shift)]++] = src[i];
+        }
+    };
+
+    /**
+     * Turns the per-thread digit counts into the position where each thread
+     * writes its first element of each digit. Returns false, leaving the
+     * counts alone, if every element has the same digit.
+     */
+    static bool offsets(int *counts, int threads, int n){
+        for(int d = 0; d < kBuckets; ++d){
+            int total = 0;
+            for(int t = 0; t < threads; ++t) total += counts[t * kBuckets + d];
+            if(total == n) return false;
+            if(total != 0) break;
+        }
+        int sum = 0;
+        for(int d = 0; d < kBuckets; ++d)
+            for(int t = 0; t < threads; ++t){
+                int c = counts[t * kBuckets + d];
+                counts[t * kBuckets + d] = sum;
+                sum += c;
+            }
+        return true;
+    }
+
+    /**
+     * Calls f(t) for every t in [first, first + count), each on its own thread.
+     */
+    template<class F>
+    static void forEach(int first, int count, const F &f){
+        if(count == 1){
+            f(first);
+            return;
+        }
+        int half = count / 2;
+        std::thread worker([&]{ forEach(first, half, f); });
+        forEach(first + half, count - half, f);
+        worker.join();
+    }
+
+    /**
+     * Merges the sorted runs [0, mid) and [mid, n) of p.
+     */
+    template<class Compare>
+    static void merge(T *p, int mid, int n, Compare cmp, int threads){
+        if(mid == 0 || mid == n) return;
+        if(threads <= 1 || n < iParallelCutoff){
+            std::inplace_merge(p, p + mid, p + n, cmp);
+            return;
+        }
+        // [0, i) and [mid, j) go before [i, mid) and [j, n). Equal elements
+        // of the left run stay in front of those of the right run.
+        int i, j;
+        if(mid >= n - mid){
+            i = mid / 2;
+            j = static_cast<int>(std::lower_bound(p + mid, p + n, p[i], cmp) - p);
+        }
+        else {
+            j = mid + (n - mid) / 2;
+            i = static_cast<int>(std::upper_bound(p, p + mid, p[j], cmp) - p);
+        }
+        std::rotate(p + i, p + mid, p + j);
+        int k = i + (j - mid);
+        std::thread worker([&]{ merge(p, i, k, cmp, threads / 2); });
+        merge(p + k, mid - i, n - k, cmp, threads - threads / 2);
+        worker.join();
+    }
+};
+
+#endif
@@ -0,0 +1,387 @@
+/** @file */
+#ifndef __PERSISTENTTREEMAP_H
+#define __PERSISTENTTREEMAP_H
+#include <cstdlib>
+#include <atomic>
+
+#include "ElementNotExist.h"
+#include "ArrayList.h"
+
+/**
+ * PersistentTreeMap is a TreeMap whose versions share structure. Nodes are
+ * never modified once they are reachable from a map: put and remove copy
+ * the O(log n) nodes on the path to the key and reuse every other subtree,
+ * so copying a map, or taking a snapshot(), is O(1).
+ *
+ * Nodes are reference counted with atomic counters and freed when the last
+ * version using them goes away. A snapshot may therefore be handed to
+ * another thread and read there while the writer keeps updating its own
+ * copy; neither side ever waits for the other. A single PersistentTreeMap
+ * object is not itself safe to share between threads.
+ *
+ * The iterators iterate through the map in the natural order (operator<)
+ * of the key, and keep the version they were created from alive.
+ */
+template<class K, class V>
+class PersistentTreeMap
+{
+public:
+    class Entry
+    {
+        K key;
+        V value;
+    public:
+        Entry(const K& k, const V& v)
+        :key(k),value(v){}
+
+        const K& getKey() const
+        {
+            return key;
+        }
+
+        const V& getValue() const
+        {
+            return value;
+        }
+    };
+
+private:
+    struct TreapNode{
+        Entry data;
+        int fix;
+        TreapNode* lf;
+        TreapNode* rt;
+        std::atomic<int> refs;
+        TreapNode(const Entry& parData, int parFix, TreapNode* parLf, TreapNode* parRt)
+        :data(parData),fix(parFix),lf(parLf),rt(parRt),refs(1){}
+    };
+
+    TreapNode *TreapRoot;
+    int iSize;
+
+    static TreapNode* acquire(TreapNode *root){
+        if(root != NULL) root->refs.fetch_add(1, std::memory_order_relaxed);
+        return root;
+    }
+
+    static void release(TreapNode *root){
+        if(root == NULL || root->refs.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+        release(root->lf);
+        release(root->rt);
+        delete root;
+    }
+
+    struct ValueMaker{
+        const V& value;
+        ValueMaker(const V& v):value(v){}
+        const V& operator()(const K&) const { return value; }
+    };
+
+    /**
+     * Returns a new version of root with key mapped to make(key), and sets
+     * at to the node holding key in it. If key is already present, present
+     * is set and, unless replace is true, NULL is returned with at set to
+     * the existing node, before anything is allocated. The returned node
+     * is fresh and owned by the caller, so it may still be changed in
+     * place; everything below it that was not on the path is shared.
+     */
+    template<class F>
+    static TreapNode* insert(const TreapNode *root, const K& key, F& make, bool replace, const TreapNode *&at, bool &present){
+        if(root == NULL){
+            TreapNode *tmp = new TreapNode(Entry(key,make(key)), rand(), NULL, NULL);
+            at = tmp;
+            return tmp;
+        }
+        if(key < root->data.getKey()){
+            TreapNode *tmp = insert(root->lf, key, make, replace, at, present);
+            if(tmp == NULL) return NULL;
+            if(tmp->fix > root->fix){
+                tmp->rt = new TreapNode(root->data, root->fix, tmp->rt, acquire(root->rt));
+                return tmp;
+            }
+            return new TreapNode(root->data, root->fix, tmp, acquire(root->rt));
+        }
+        if(root->data.getKey() < key){
+            TreapNode *tmp = insert(root->rt, key, make, replace, at, present);
+            if(tmp == NULL) return NULL;
+            if(tmp->fix > root->fix){
+                tmp->lf = new TreapNode(root->data, root->fix, acquire(root->lf), tmp->lf);
+                return tmp;
+            }
+            return new TreapNode(root->data, root->fix, acquire(root->lf), tmp);
+        }
+        present = true;
+        if(!replace){
+            at = root;
+            return NULL;
+        }
+        TreapNode *tmp = new TreapNode(Entry(key,make(key)), root->fix, acquire(root->lf), acquire(root->rt));
+        at = tmp;
+        return tmp;
+    }
+
+    /**
+     * Makes the version returned by insert the current one, unless insert
+     * returned NULL, and returns the node holding the key.
+     */
+    template<class F>
+    const TreapNode* locate(const K& key, F& make, bool replace, bool &present){
+        const TreapNode *at = NULL;
+        present = false;
+        TreapNode *tmp = insert(TreapRoot, key, make, replace, at, present);
+        if(tmp != NULL){
+            release(TreapRoot);
+            TreapRoot = tmp;
+            if(!present) ++iSize;
+        }
+        return at;
+    }
+
+    /**
+     * Returns a new treap holding the keys of a followed by those of b.
+     */
+    static TreapNode* join(TreapNode *a, TreapNode *b){
+        if(a == NULL) return acquire(b);
+        if(b == NULL) return acquire(a);
+        if(a->fix > b->fix) return new TreapNode(a->data, a->fix, acquire(a->lf), join(a->rt, b));
+        return new TreapNode(b->data, b->fix, join(a, b->lf), acquire(b->rt));
+    }
+
+    /**
+     * Returns a new version of root without key, which must be present.
+     */
+    static TreapNode* remove(const TreapNode *root, const K& key){
+        if(key < root->data.getKey())
+            return new TreapNode(root->data, root->fix, remove(root->lf, key), acquire(root->rt));
+        if(root->data.getKey() < key)
+            return new TreapNode(root->data, root->fix, acquire(root->lf), remove(root->rt, key));
+        return join(root->lf, root->rt);
+    }
+
+    const TreapNode* lookup(const K& key) const{
+        const TreapNode *root = TreapRoot;
+        while(root != NULL){
+            if(key < root->data.getKey()) root = root->lf;
+            else if(root->data.getKey() < key) root = root->rt;
+            else return root;
+        }
+        return NULL;
+    }
+
+public:
+    class Iterator
+    {
+    private:
+        TreapNode *pRoot;
+        ArrayList<const TreapNode*> stack;
+        void pushLeft(const TreapNode *root){
+            for(; root != NULL; root = root->lf) stack.add(root);
+        }
+    public:
+        Iterator(const PersistentTreeMap* parMap)
+        :pRoot(acquire(parMap->TreapRoot)){
+            pushLeft(pRoot);
+        }
+        Iterator(const Iterator &x)
+        :pRoot(acquire(x.pRoot)),stack(x.stack){}
+        Iterator &operator=(const Iterator &x){
+            acquire(x.pRoot);
+            release(pRoot);
+            pRoot = x.pRoot;
+            stack = x.stack;
+            return *this;
+        }
+        ~Iterator(){
+            release(pRoot);
+        }
+        /**
+         * Returns true if the iteration has more elements.
+         */
+        bool hasNext() {
+            return !stack.isEmpty();
+        }
+
+        /**
+         * Returns the next element in the iteration.
+         * @throw ElementNotExist exception when hasNext() == false
+         */
+        const Entry &next() {
+            if(!hasNext()) throw ElementNotExist();
+            const TreapNode *tmp = stack.get(stack.size() - 1);
+            stack.removeIndex(stack.size() - 1);
+            pushLeft(tmp->rt);
+            return tmp->data;
+        }
+    };
+
+    /**
+     * Constructs an empty map.
+     */
+    PersistentTreeMap()
+    :TreapRoot(NULL),iSize(0){}
+
+    /**
+     * Destructor. Frees the nodes no other version shares.
+     */
+    ~PersistentTreeMap() {
+        release(TreapRoot);
+    }
+
+    /**
+     * Assignment operator. Shares the nodes of x in O(1).
+     */
+    PersistentTreeMap &operator=(const PersistentTreeMap &x) {
+        acquire(x.TreapRoot);
+        release(TreapRoot);
+        TreapRoot = x.TreapRoot;
+        iSize = x.iSize;
+        return *this;
+    }
+
+    /**
+     * Copy-constructor. Shares the nodes of x in O(1).
+     */
+    PersistentTreeMap(const PersistentTreeMap &x)
+    :TreapRoot(acquire(x.TreapRoot)),iSize(x.iSize){}
+
+    /**
+     * Returns a read-only version of the current contents in O(1). Later
+     * updates to this map do not show through it.
+     */
+    PersistentTreeMap snapshot() const {
+        return *this;
+    }
+
+    /**
+     * Returns an iterator over the elements in this map.
+     */
+    Iterator iterator() const {
+        return Iterator(this);
+    }
+
+    /**
+     * Removes all of the mappings from this map.
+     */
+    void clear() {
+        release(TreapRoot);
+        TreapRoot = NULL;
+        iSize = 0;
+    }
+
+    /**
+     * Returns true if this map contains a mapping for the specified key.
+     */
+    bool containsKey(const K &key) const {
+        return lookup(key) != NULL;
+    }
+
+    /**
+     * Returns true if this map maps one or more keys to the specified value.
+     */
+    bool containsValue(const V &value) const {
+        for(Iterator itr = iterator(); itr.hasNext();){
+            if(itr.next().getValue() == value) return true;
+        }
+        return false;
+    }
+
+    /**
+     * Returns a const reference to the value to which the specified key is mapped.
+     * The reference stays valid while this version, or a copy of it, exists.
+     * @throw ElementNotExist
+     */
+    const V &get(const K &key) const {
+        const TreapNode *tmp = lookup(key);
+        if(tmp == NULL) throw ElementNotExist();
+        return tmp->data.getValue();
+    }
+
+    /**
+     * Returns the entry mapped to key, or NULL if the key is not present.
+     */
+    const Entry *find(const K &key) const {
+        const TreapNode *tmp = lookup(key);
+        return tmp == NULL ? NULL : &tmp->data;
+    }
+
+    /**
+     * Copies the value mapped to key into value and returns true, or
+     * returns false and leaves value untouched if the key is not present.
+     */
+    bool tryGet(const K &key, V &value) const {
+        const TreapNode *tmp = lookup(key);
+        if(tmp == NULL) return false;
+        value = tmp->data.getValue();
+        return true;
+    }
+
+    /**
+     * Returns the value mapped to key, or defaultValue if the key is not present.
+     */
+    V getOrDefault(const K &key, const V &defaultValue) const {
+        const TreapNode *tmp = lookup(key);
+        return tmp == NULL ? defaultValue : tmp->data.getValue();
+    }
+
+    /**
+     * Returns true if this map contains no key-value mappings.
+     */
+    bool isEmpty() const {
+        return !iSize;
+    }
+
+    /**
+     * Associates the specified value with the specified key in this map.
+     * Allocates O(log n) nodes; other versions are unaffected.
+     */
+    void put(const K &key, const V &value) {
+        ValueMaker make(value);
+        bool present;
+        locate(key, make, true, present);
+    }
+
+    /**
+     * Associates the specified value with the specified key only if the key
+     * is not already mapped. Returns true if the value was put. A present
+     * key costs one walk and no allocation.
+     */
+    bool putIfAbsent(const K &key, const V &value) {
+        ValueMaker make(value);
+        bool present;
+        locate(key, make, false, present);
+        return !present;
+    }
+
+    /**
+     * Returns the value mapped to key, first mapping it to fn(key) if the
+     * key is absent. fn is only called when the key is absent. The
+     * reference stays valid while this version, or a copy of it, exists.
+     */
+    template<class F>
+    const V &computeIfAbsent(const K &key, F fn) {
+        bool present;
+        return locate(key, fn, false, present)->data.getValue();
+    }
+
+    /**
+     * Removes the mapping for the specified key from this map.
+     * Allocates O(log n) nodes; other versions are unaffected.
+     * @throw ElementNotExist
+     */
+    void remove(const K &key) {
+        if(lookup(key) == NULL) throw ElementNotExist();
+        TreapNode *tmp = remove(TreapRoot, key);
+        release(TreapRoot);
+        TreapRoot = tmp;
+        --iSize;
+    }
+
+    /**
+     * Returns the number of key-value mappings in this map.
+     */
+    int size() const {
+        return iSize;
+    }
+};
+
+#endif
@@ -0,0 +1,790 @@
+/** @file */
+#ifndef __RADIXTREEMAP_H
+#define __RADIXTREEMAP_H
+
+#include <cstring>
+#include <type_traits>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+#include "ElementNotExist.h"
+#include "TreeMap.h"
+
+/**
+ * RadixTreeMap is an ordered map for integral keys. It is an adaptive radix tree: a key is read one byte at a time,
+ * most significant first, and each byte indexes the next child directly,
+ * so a lookup takes at most sizeof(K) steps and no key comparisons except
+ * one at the leaf. Signed keys have their sign bit flipped, which makes
+ * the byte order agree with operator<.
+ *
+ * Inner nodes with at most 16 children keep their key bytes in one sorted
+ * 16-byte array that is searched with a single SSE2 compare; fuller nodes
+ * switch to a plain array of 256 children, and shrink back once they drop
+ * to 12. A node only exists where keys diverge: it records the byte it
+ * branches on and a key that shares everything above, so runs of common
+ * leading bytes, such as the high bytes of 64-bit IDs or timestamps, cost
+ * nothing. A leaf sits directly below the first node where its key is
+ * unique.
+ *
+ * The leaves are chained in key order, so iteration is O(1) per step and
+ * the floor and ceiling of a key are found with one descent.
+ *
+ * It has the core interface of TreeMap: copying and moving, iterator,
+ * descendingIterator, clear, containsKey, containsValue, get, find,
+ * tryGet, getOrDefault, isEmpty, put, putIfAbsent, computeIfAbsent,
+ * remove, size, the floor, ceiling, higher, lower, first and last entries,
+ * pollFirst and pollLast. Nodes carry no subtree counts or aggregates, so
+ * rank, select, countRange, aggregate, subMap views, fromSorted, splitAt
+ * and the set operations are TreeMap only.
+ *
+ * OrderedMapFor<K, V>::Type, defined below, picks this map for integral
+ * keys and TreeMap for everything else.
+ */
+template<class K, class V>
+class RadixTreeMap
+{
+    static_assert(std::is_integral<K>::value && !std::is_same<K, bool>::value,
+                  "RadixTreeMap needs an integral key type");
+public:
+    class Entry
+    {
+        K key;
+        V value;
+    public:
+        Entry(const K& k, const V& v)
+        :key(k),value(v){}
+
+        void setValue(const V& v){
+            value = v;
+        }
+
+        const K& getKey() const
+        {
+            return key;
+        }
+
+        const V& getValue() const
+        {
+            return value;
+        }
+    };
+
+private:
+    typedef typename std::make_unsigned<K>::type U;
+    static const int iBytes = sizeof(K);
+
+    enum NodeType { kLeaf, kNode16, kNode256 };
+
+    /**
+     * Children of inner nodes are inner nodes or leaves, told apart by type.
+     */
+    struct Node{
+        unsigned char type;
+        explicit Node(unsigned char parType):type(parType){}
+    };
+
+    struct Leaf : Node{
+        U bits;
+        Leaf *prev;
+        Leaf *next;
+        Entry data;
+        Leaf(U parBits, const K& k, const V& v)
+        :Node(kLeaf),bits(parBits),prev(NULL),next(NULL),data(k,v){}
+    };
+
+    /**
+     * Branches on byte depth of the key. All keys below agree with prefix
+     * on the bytes before it.
+     */
+    struct Inner : Node{
+        unsigned char depth;
+        int count;
+        U prefix;
+        Inner(unsigned char parType, int parDepth, U parPrefix)
+        :Node(parType),depth(static_cast<unsigned char>(parDepth)),count(0),prefix(parPrefix){}
+    };
+
+    struct Node16 : Inner{
+        unsigned char keys[16];
+        Node *child[16];
+        Node16(int parDepth, U parPrefix)
+        :Inner(kNode16,parDepth,parPrefix){
+            memset(keys, 0, sizeof(keys));
+        }
+    };
+
+    struct Node256 : Inner{
+        Node *child[256];
+        Node256(int parDepth, U parPrefix)
+        :Inner(kNode256,parDepth,parPrefix){
+            memset(child, 0, sizeof(child));
+        }
+    };
+
+    static const int iShrinkCount = 12;
+
+    Node *pRoot;
+    Leaf *pFirst;
+    Leaf *pLast;
+    int iSize;
+
+    static U toBits(const K& key){
+        U bits = static_cast<U>(key);
+        if(std::is_signed<K>::value) bits ^= static_cast<U>(U(1) << (iBytes * 8 - 1));
+        return bits;
+    }
+
+    static unsigned char byteAt(U bits, int depth){
+        return static_cast<unsigned char>(bits >> ((iBytes - 1 - depth) * 8));
+    }
+
+    static bool sharesPrefix(const Inner *node, U bits){
+        return node->depth == 0 || ((node->prefix ^ bits) >> ((iBytes - node->depth) * 8)) == 0;
+    }
+
+    static int firstDifferentByte(U a, U b){
+        int depth = 0;
+        while(byteAt(a, depth) == byteAt(b, depth)) ++depth;
+        return depth;
+    }
+
+    /**
+     * A key below node; for an inner node only its leading bytes matter.
+     */
+    static U bitsOf(const Node *node){
+        if(node->type == kLeaf) return static_cast<const Leaf*>(node)->bits;
+        return static_cast<const Inner*>(node)->prefix;
+    }
+
+    /**
+     * Position of byte among the children of node, or -1.
+     */
+    static int indexOf(const Node16 *node, unsigned char byte){
+#if defined(__SSE2__) || defined(_M_X64)
+        __m128i cmp = _mm_cmpeq_epi8(_mm_set1_epi8(static_cast<char>(byte)),
+                                     _mm_loadu_si128(reinterpret_cast<const __m128i*>(node->keys)));
+        int mask = _mm_movemask_epi8(cmp) & ((1 << node->count) - 1);
+        if(mask == 0) return -1;
+#if defined(__GNUC__)
+        return __builtin_ctz(mask);
+#else
+        int i = 0;
+        while(!(mask & 1)){ mask >>= 1; ++i; }
+        return i;
+#endif
+#else
+        for(int i=0; i<node->count; ++i) if(node->keys[i] == byte) return i;
+        return -1;
+#endif
+    }
+
+    /**
+     * Returns the link to the child of node for byte, or NULL if there is none.
+     */
+    static Node** findChild(Node *node, unsigned char byte){
+        if(node->type == kNode16){
+            Node16 *tmp = static_cast<Node16*>(node);
+            int i = indexOf(tmp, byte);
+            return i < 0 ? NULL : tmp->child + i;
+        }
+        Node256 *tmp = static_cast<Node256*>(node);
+        return tmp->child[byte] == NULL ? NULL : tmp->child + byte;
+    }
+
+    /**
+     * Returns the child of node with the least byte greater than byte
+     * (or not less than it, if inclusive), or NULL.
+     */
+    static Node* childFrom(const Node *node, int byte, bool inclusive){
+        if(!inclusive) ++byte;
+        if(node->type == kNode16){
+            const Node16 *tmp = static_cast<const Node16*>(node);
+            for(int i=0; i<tmp->count; ++i) if(tmp->keys[i] >= byte) return tmp->child[i];
+            return NULL;
+        }
+        const Node256 *tmp = static_cast<const Node256*>(node);
+        for(int i=byte; i<256; ++i) if(tmp->child[i] != NULL) return tmp->child[i];
+        return NULL;
+    }
+
+    static Leaf* minLeaf(Node *node){
+        while(node->type != kLeaf) node = childFrom(node, 0, true);
+        return static_cast<Leaf*>(node);
+    }
+
+    /**
+     * Adds child under byte to the inner node in slot, growing it if full.
+     */
+    static void addChild(Node *&slot, unsigned char byte, Node *child){
+        if(slot->type == kNode16){
+            Node16 *tmp = static_cast<Node16*>(slot);
+            if(tmp->count < 16){
+                int i = tmp->count;
+                for(; i > 0 && tmp->keys[i - 1] > byte; --i){
+                    tmp->keys[i] = tmp->keys[i - 1];
+                    tmp->child[i] = tmp->child[i - 1];
+                }
+                tmp->keys[i] = byte;
+                tmp->child[i] = child;
+                ++tmp->count;
+                return;
+            }
+            Node256 *big = new Node256(tmp->depth, tmp->prefix);
+            for(int i=0; i<tmp->count; ++i) big->child[tmp->keys[i]] = tmp->child[i];
+            big->count = tmp->count;
+            delete tmp;
+            slot = big;
+        }
+        Node256 *tmp = static_cast<Node256*>(slot);
+        tmp->child[byte] = child;
+        ++tmp->count;
+    }
+
+    /**
+     * Drops the child under byte from the inner node in slot. A node left
+     * with one child is replaced by it; a sparse Node256 becomes a Node16.
+     */
+    static void removeChild(Node *&slot, unsigned char byte){
+        if(slot->type == kNode16){
+            Node16 *tmp = static_cast<Node16*>(slot);
+            int i = indexOf(tmp, byte);
+            for(--tmp->count; i < tmp->count; ++i){
+                tmp->keys[i] = tmp->keys[i + 1];
+                tmp->child[i] = tmp->child[i + 1];
+            }
+            if(tmp->count == 1){
+                slot = tmp->child[0];
+                delete tmp;
+            }
+            return;
+        }
+        Node256 *tmp = static_cast<Node256*>(slot);
+        tmp->child[byte] = NULL;
+        if(--tmp->count > iShrinkCount) return;
+        Node16 *small = new Node16(tmp->depth, tmp->prefix);
+        for(int i=0; i<256; ++i){
+            if(tmp->child[i] == NULL) continue;
+            small->keys[small->count] = static_cast<unsigned char>(i);
+            small->child[small->count++] = tmp->child[i];
+        }
+        delete tmp;
+        slot = small;
+    }
+
+    static void destroy(Node *node){
+        if(node == NULL) return;
+        if(node->type == kLeaf){
+            delete static_cast<Leaf*>(node);
+            return;
+        }
+        if(node->type == kNode16){
+            Node16 *tmp = static_cast<Node16*>(node);
+            for(int i=0; i<tmp->count; ++i) destroy(tmp->child[i]);
+            delete tmp;
+            return;
+        }
+        Node256 *tmp = static_cast<Node256*>(node);
+        for(int i=0; i<256; ++i) destroy(tmp->child[i]);
+        delete tmp;
+    }
+
+    /**
+     * Returns the least leaf below node whose key is not less than bits, or NULL.
+     */
+    static Leaf* ceilingIn(Node *node, U bits){
+        if(node == NULL) return NULL;
+        if(node->type == kLeaf){
+            Leaf *tmp = static_cast<Leaf*>(node);
+            return bits <= tmp->bits ? tmp : NULL;
+        }
+        Inner *tmp = static_cast<Inner*>(node);
+        if(!sharesPrefix(tmp, bits)) return bits < tmp->prefix ? minLeaf(node) : NULL;
+        unsigned char byte = byteAt(bits, tmp->depth);
+        Node **child = findChild(node, byte);
+        if(child != NULL){
+            Leaf *result = ceilingIn(*child, bits);
+            if(result != NULL) return result;
+        }
+        Node *next = childFrom(node, byte, false);
+        return next == NULL ? NULL : minLeaf(next);
+    }
+
+    Leaf* ceilingLeaf(U bits) const{
+        return ceilingIn(pRoot, bits);
+    }
+
+    /**
+     * Returns the greatest leaf whose key is not greater than bits, or NULL.
+     */
+    Leaf* floorLeaf(U bits) const{
+        Leaf *tmp = ceilingLeaf(bits);
+        if(tmp != NULL && tmp->bits == bits) return tmp;
+        return tmp == NULL ? pLast : tmp->prev;
+    }
+
+    /**
+     * Descends without checking the skipped prefixes; the leaf comparison
+     * at the end catches any mismatch.
+     */
+    Leaf* lookup(const K& key) const{
+        U bits = toBits(key);
+        Node *node = pRoot;
+        while(node != NULL && node->type != kLeaf){
+            Node **child = findChild(node, byteAt(bits, static_cast<Inner*>(node)->depth));
+            node = child == NULL ? NULL : *child;
+        }
+        Leaf *tmp = static_cast<Leaf*>(node);
+        return (tmp != NULL && tmp->bits == bits) ? tmp : NULL;
+    }
+
+    /**
+     * Joins node and leaf, whose keys first differ at byte depth, under a new node.
+     */
+    static Node* branch(int depth, Node *node, Leaf *leaf){
+        Node *tmp = new Node16(depth, leaf->bits);
+        addChild(tmp, byteAt(bitsOf(node), depth), node);
+        addChild(tmp, byteAt(leaf->bits, depth), leaf);
+        return tmp;
+    }
+
+    /**
+     * Chains a freshly inserted leaf between its neighbours.
+     */
+    void link(Leaf *leaf){
+        Leaf *next = leaf->bits == static_cast<U>(~U(0)) ? NULL : ceilingLeaf(static_cast<U>(leaf->bits + 1));
+        leaf->next = next;
+        leaf->prev = next == NULL ? pLast : next->prev;
+        if(leaf->prev != NULL) leaf->prev->next = leaf;
+        else pFirst = leaf;
+        if(next != NULL) next->prev = leaf;
+        else pLast = leaf;
+    }
+
+    /**
+     * Returns the leaf of key. If there is none, one holding make(key) is
+     * inserted and inserted is set to true.
+     */
+    template<class F>
+    Leaf* locate(const K& key, F& make, bool& inserted){
+        U bits = toBits(key);
+        Node **slot = &pRoot;
+        Leaf *leaf = NULL;
+        while(leaf == NULL){
+            Node *node = *slot;
+            if(node == NULL){
+                *slot = leaf = new Leaf(bits, key, make(key));
+            }
+            else if(node->type == kLeaf){
+                Leaf *tmp = static_cast<Leaf*>(node);
+                if(tmp->bits == bits) return tmp;
+                leaf = new Leaf(bits, key, make(key));
+                *slot = branch(firstDifferentByte(tmp->bits, bits), node, leaf);
+            }
+            else {
+                Inner *tmp = static_cast<Inner*>(node);
+                if(!sharesPrefix(tmp, bits)){
+                    leaf = new Leaf(bits, key, make(key));
+                    *slot = branch(firstDifferentByte(tmp->prefix, bits), node, leaf);
+                }
+                else {
+                    unsigned char byte = byteAt(bits, tmp->depth);
+                    Node **child = findChild(node, byte);
+                    if(child != NULL) slot = child;
+                    else {
+                        leaf = new Leaf(bits, key, make(key));
+                        addChild(*slot, byte, leaf);
+                    }
+                }
+            }
+        }
+        link(leaf);
+        ++iSize;
+        inserted = true;
+        return leaf;
+    }
+
+    struct ValueMaker{
+        const V& value;
+        ValueMaker(const V& v):value(v){}
+        const V& operator()(const K&) const { return value; }
+    };
+
+    void copyFrom(const RadixTreeMap &x){
+        for(Leaf *tmp = x.pFirst; tmp != NULL; tmp = tmp->next) put(tmp->data.getKey(), tmp->data.getValue());
+    }
+
+    static const Entry* entryOf(const Leaf *leaf){
+        return leaf == NULL ? NULL : &leaf->data;
+    }
+
+public:
+    /**
+     * Iterates in key order, or in descending order when obtained through
+     * descendingIterator(). This is what a const map hands out; Iterator
+     * adds remove().
+     */
+    class ConstIterator
+    {
+    protected:
+        Leaf *pNext;
+        Leaf *pLast;
+        bool descending;
+    public:
+        ConstIterator(const RadixTreeMap *parMap, bool parDescending = false)
+        :pNext(parDescending ? parMap->pLast : parMap->pFirst),pLast(NULL),descending(parDescending){}
+        /**
+         * Returns true if the iteration has more elements.
+         */
+        bool hasNext() {
+            return pNext != NULL;
+        }
+
+        /**
+         * Returns the next element in the iteration.
+         * @throw ElementNotExist exception when hasNext() == false
+         */
+        const Entry &next() {
+            if(!hasNext()) throw ElementNotExist();
+            pLast = pNext;
+            pNext = descending ? pNext->prev : pNext->next;
+            return pLast->data;
+        }
+    };
+
+    /**
+     * A ConstIterator over a mutable map, which may also remove entries.
+     */
+    class Iterator : public ConstIterator
+    {
+    private:
+        RadixTreeMap *pMap;
+    public:
+        Iterator(RadixTreeMap *parMap, bool parDescending = false)
+        :ConstIterator(parMap, parDescending),pMap(parMap){}
+
+        /**
+         * Removes from the underlying map the last element returned by the
+         * iterator. The iteration may continue afterwards.
+         * @throw ElementNotExist
+         */
+        void remove() {
+            if(this->pLast == NULL) throw ElementNotExist();
+            pMap->remove(this->pLast->data.getKey());
+            this->pLast = NULL;
+        }
+    };
+
+    /**
+     * Constructs an empty map.
+     */
+    RadixTreeMap()
+    :pRoot(NULL),pFirst(NULL),pLast(NULL),iSize(0){}
+
+    /**
+     * Destructor
+     */
+    ~RadixTreeMap() {
+        destroy(pRoot);
+    }
+
+    /**
+     * Copy-constructor
+     */
+    RadixTreeMap(const RadixTreeMap &x)
+    :pRoot(NULL),pFirst(NULL),pLast(NULL),iSize(0) {
+        copyFrom(x);
+    }
+
+    /**
+     * Assignment operator
+     */
+    RadixTreeMap &operator=(const RadixTreeMap &x) {
+        if(this == &x) return *this;
+        clear();
+        copyFrom(x);
+        return *this;
+    }
+
+    /**
+     * Move-constructor. x is left empty.
+     */
+    RadixTreeMap(RadixTreeMap &&x)
+    :pRoot(x.pRoot),pFirst(x.pFirst),pLast(x.pLast),iSize(x.iSize) {
+        x.pRoot = NULL;
+        x.pFirst = x.pLast = NULL;
+        x.iSize = 0;
+    }
+
+    /**
+     * Move assignment operator. x is left empty.
+     */
+    RadixTreeMap &operator=(RadixTreeMap &&x) {
+        if(this == &x) return *this;
+        clear();
+        pRoot = x.pRoot;
+        pFirst = x.pFirst;
+        pLast = x.pLast;
+        iSize = x.iSize;
+        x.pRoot = NULL;
+        x.pFirst = x.pLast = NULL;
+        x.iSize = 0;
+        return *this;
+    }
+
+    /**
+     * Returns an iterator over the elements in this map in key order.
+     */
+    Iterator iterator() {
+        return Iterator(this);
+    }
+
+    /**
+     * Returns a read-only iterator over the elements in this map in key order.
+     */
+    ConstIterator iterator() const {
+        return ConstIterator(this);
+    }
+
+    /**
+     * Returns an iterator over the elements in this map in descending key order.
+     */
+    Iterator descendingIterator() {
+        return Iterator(this, true);
+    }
+
+    /**
+     * Returns a read-only iterator over the elements in this map in
+     * descending key order.
+     */
+    ConstIterator descendingIterator() const {
+        return ConstIterator(this, true);
+    }
+
+    /**
+     * Removes all of the mappings from this map.
+     */
+    void clear() {
+        destroy(pRoot);
+        pRoot = NULL;
+        pFirst = pLast = NULL;
+        iSize = 0;
+    }
+
+    /**
+     * Returns true if this map contains a mapping for the specified key.
+     */
+    bool containsKey(const K &key) const {
+        return lookup(key) != NULL;
+    }
+
+    /**
+     * Returns true if this map maps one or more keys to the specified value.
+     */
+    bool containsValue(const V &value) const {
+        for(Leaf *tmp = pFirst; tmp != NULL; tmp = tmp->next){
+            if(tmp->data.getValue() == value) return true;
+        }
+        return false;
+    }
+
+    /**
+     * Returns a const reference to the value to which the specified key is mapped.
+     * @throw ElementNotExist
+     */
+    const V &get(const K &key) const {
+        Leaf *tmp = lookup(key);
+        if(tmp == NULL) throw ElementNotExist();
+        return tmp->data.getValue();
+    }
+
+    /**
+     * Returns the entry mapped to key, or NULL if the key is not present.
+     */
+    const Entry *find(const K &key) const {
+        return entryOf(lookup(key));
+    }
+
+    /**
+     * Copies the value mapped to key into value and returns true, or
+     * returns false and leaves value untouched if the key is not present.
+     */
+    bool tryGet(const K &key, V &value) const {
+        Leaf *tmp = lookup(key);
+        if(tmp == NULL) return false;
+        value = tmp->data.getValue();
+        return true;
+    }
+
+    /**
+     * Returns the value mapped to key, or defaultValue if the key is not present.
+     */
+    V getOrDefault(const K &key, const V &defaultValue) const {
+        Leaf *tmp = lookup(key);
+        return tmp == NULL ? defaultValue : tmp->data.getValue();
+    }
+
+    /**
+     * Returns true if this map contains no key-value mappings.
+     */
+    bool isEmpty() const {
+        return !iSize;
+    }
+
+    /**
+     * Associates the specified value with the specified key in this map.
+     */
+    void put(const K &key, const V &value) {
+        bool inserted = false;
+        ValueMaker make(value);
+        Leaf *tmp = locate(key, make, inserted);
+        if(!inserted) tmp->data.setValue(value);
+    }
+
+    /**
+     * Associates the specified value with the specified key only if the key
+     * is not already mapped. Returns true if the value was put.
+     */
+    bool putIfAbsent(const K &key, const V &value) {
+        bool inserted = false;
+        ValueMaker make(value);
+        locate(key, make, inserted);
+        return inserted;
+    }
+
+    /**
+     * Returns the value mapped to key, first mapping it to fn(key) if the
+     * key is absent. fn is only called when the key is absent.
+     */
+    template<class F>
+    const V &computeIfAbsent(const K &key, F fn) {
+        bool inserted = false;
+        return locate(key, fn, inserted)->data.getValue();
+    }
+
+    /**
+     * Removes the mapping for the specified key from this map.
+     * @throw ElementNotExist
+     */
+    void remove(const K &key) {
+        U bits = toBits(key);
+        Node **slot = &pRoot;
+        Node **parent = NULL;
+        while(*slot != NULL && (*slot)->type != kLeaf){
+            Node **child = findChild(*slot, byteAt(bits, static_cast<Inner*>(*slot)->depth));
+            if(child == NULL) throw ElementNotExist();
+            parent = slot;
+            slot = child;
+        }
+        Leaf *leaf = static_cast<Leaf*>(*slot);
+        if(leaf == NULL || leaf->bits != bits) throw ElementNotExist();
+        if(leaf->prev != NULL) leaf->prev->next = leaf->next;
+        else pFirst = leaf->next;
+        if(leaf->next != NULL) leaf->next->prev = leaf->prev;
+        else pLast = leaf->prev;
+        if(parent == NULL) pRoot = NULL;
+        else removeChild(*parent, byteAt(bits, static_cast<Inner*>(*parent)->depth));
+        delete leaf;
+        --iSize;
+    }
+
+    /**
+     * Returns the number of key-value mappings in this map.
+     */
+    int size() const {
+        return iSize;
+    }
+
+    /**
+     * Returns the entry with the greatest key less than or equal to key,
+     * or NULL if there is none.
+     */
+    const Entry *floorEntry(const K &key) const {
+        return entryOf(floorLeaf(toBits(key)));
+    }
+
+    /**
+     * Returns the entry with the least key greater than or equal to key,
+     * or NULL if there is none.
+     */
+    const Entry *ceilingEntry(const K &key) const {
+        return entryOf(ceilingLeaf(toBits(key)));
+    }
+
+    /**
+     * Returns the entry with the least key strictly greater than key,
+     * or NULL if there is none.
+     */
+    const Entry *higherEntry(const K &key) const {
+        U bits = toBits(key);
+        if(bits == static_cast<U>(~U(0))) return NULL;
+        return entryOf(ceilingLeaf(static_cast<U>(bits + 1)));
+    }
+
+    /**
+     * Returns the entry with the greatest key strictly less than key,
+     * or NULL if there is none.
+     */
+    const Entry *lowerEntry(const K &key) const {
+        U bits = toBits(key);
+        if(bits == 0) return NULL;
+        return entryOf(floorLeaf(static_cast<U>(bits - 1)));
+    }
+
+    /**
+     * Returns the entry with the least key, or NULL if this map is empty.
+     */
+    const Entry *firstEntry() const {
+        return entryOf(pFirst);
+    }
+
+    /**
+     * Returns the entry with the greatest key, or NULL if this map is empty.
+     */
+    const Entry *lastEntry() const {
+        return entryOf(pLast);
+    }
+
+    /**
+     * Removes the entry with the least key and returns a copy of it.
+     * @throw ElementNotExist if this map is empty
+     */
+    Entry pollFirst() {
+        if(pFirst == NULL) throw ElementNotExist();
+        Entry result = pFirst->data;
+        remove(result.getKey());
+        return result;
+    }
+
+    /**
+     * Removes the entry with the greatest key and returns a copy of it.
+     * @throw ElementNotExist if this map is empty
+     */
+    Entry pollLast() {
+        if(pLast == NULL) throw ElementNotExist();
+        Entry result = pLast->data;
+        remove(result.getKey());
+        return result;
+    }
+};
+
+/**
+ * OrderedMapFor<K, V>::Type is the ordered map best suited to K:
+ * RadixTreeMap for integral keys and TreeMap for anything else. Code that
+ * uses it must stick to the core interface the two share, listed on
+ * RadixTreeMap; anything beyond it compiles only for some key types.
+ */
+template<class K, class V, bool = std::is_integral<K>::value && !std::is_same<K, bool>::value>
+struct OrderedMapFor
+{
+    typedef TreeMap<K, V> Type;
+};
+
+template<class K, class V>
+struct OrderedMapFor<K, V, true>
+{
+    typedef RadixTreeMap<K, V> Type;
+};
+
+#endif
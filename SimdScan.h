@@ -0,0 +1,265 @@
+/** @file */
+#ifndef __SIMDSCAN_H
+#define __SIMDSCAN_H
+
+#include <cstring>
+#include <type_traits>
+
+/**
+ * SumOf<T>::Type is what ArrayList::sum() returns: a 64-bit integer of the
+ * same signedness for integral types, double for floating point types, and
+ * T itself for anything else.
+ */
+template<class T, bool = std::is_arithmetic<T>::value>
+struct SumOf
+{
+    typedef T Type;
+};
+
+template<class T>
+struct SumOf<T, true>
+{
+    typedef typename std::conditional<std::is_floating_point<T>::value, double,
+            typename std::conditional<std::is_signed<T>::value, long long, unsigned long long>::type>::type Type;
+};
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+
+/**
+ * The scan kernels, written once for vectors of N bytes with the GCC vector
+ * extensions. They are always inlined, so each copy is compiled for the
+ * instruction set of the SimdScan entry point that calls it: SSE2 for 16
+ * bytes, AVX2 for 32 and AVX-512 for 64.
+ */
+template<class T, int N>
+struct VectorScan
+{
+    typedef T V __attribute__((vector_size(N)));
+    typedef typename SumOf<T>::Type S;
+    static const int L = N / sizeof(T);
+
+    /**
+     * Lane counters are flushed after this many vectors, before 8-bit lanes
+     * can overflow.
+     */
+    static const int iFlush = 64;
+
+    /**
+     * True if a lane of m is non-zero. The kernels add their compare masks
+     * rather than or them: each lane stays in [-4, 0] either way, and GCC
+     * splits or-ed AVX-512 masks into scalar code.
+     */
+    template<class M>
+    static inline __attribute__((always_inline)) bool any(const M& m){
+        unsigned long long w[N / 8];
+        memcpy(w, &m, N);
+        unsigned long long r = 0;
+        for(int k=0; k<N/8; ++k) r |= w[k];
+        return r != 0;
+    }
+
+    static inline __attribute__((always_inline)) int indexOf(const T *p, int n, T v){
+        V s;
+        for(int k=0; k<L; ++k) s[k] = v;
+        int i = 0;
+        for(; i + 4 * L <= n; i += 4 * L){
+            V a, b, c, d;
+            memcpy(&a, p + i, N);
+            memcpy(&b, p + i + L, N);
+            memcpy(&c, p + i + 2 * L, N);
+            memcpy(&d, p + i + 3 * L, N);
+            if(any((a == s) + (b == s) + (c == s) + (d == s))) break;
+        }
+        for(; i < n; ++i) if(p[i] == v) return i;
+        return -1;
+    }
+
+    static inline __attribute__((always_inline)) int lastIndexOf(const T *p, int n, T v){
+        V s;
+        for(int k=0; k<L; ++k) s[k] = v;
+        int i = n;
+        for(; i - 4 * L >= 0; i -= 4 * L){
+            V a, b, c, d;
+            memcpy(&a, p + i - 4 * L, N);
+            memcpy(&b, p + i - 3 * L, N);
+            memcpy(&c, p + i - 2 * L, N);
+            memcpy(&d, p + i - L, N);
+            if(any((a == s) + (b == s) + (c == s) + (d == s))) break;
+        }
+        for(--i; i >= 0; --i) if(p[i] == v) return i;
+        return -1;
+    }
+
+    static inline __attribute__((always_inline)) int count(const T *p, int n, T v){
+        typedef __typeof__(V() == V()) M;
+        V s;
+        for(int k=0; k<L; ++k) s[k] = v;
+        int total = 0;
+        int i = 0;
+        while(i + L <= n){
+            M acc = M();
+            for(int j=0; j<iFlush && i + L <= n; ++j, i += L){
+                V a;
+                memcpy(&a, p + i, N);
+                acc -= (a == s);
+            }
+            for(int k=0; k<L; ++k) total += static_cast<int>(acc[k]);
+        }
+        for(; i < n; ++i) total += (p[i] == v);
+        return total;
+    }
+
+    /**
+     * Keeps the lane-wise least (or, if Greatest, greatest) element; ties
+     * and NaNs resolve as in the scalar loop p[i] < m ? p[i] : m.
+     */
+    template<bool Greatest>
+    static inline __attribute__((always_inline)) T extreme(const T *p, int n){
+        V acc;
+        for(int k=0; k<L; ++k) acc[k] = p[0];
+        int i = 0;
+        for(; i + L <= n; i += L){
+            V a;
+            memcpy(&a, p + i, N);
+            acc = Greatest ? (acc < a ? a : acc) : (a < acc ? a : acc);
+        }
+        T result = p[0];
+        for(int k=0; k<L; ++k) result = Greatest ? (result < acc[k] ? acc[k] : result) : (acc[k] < result ? acc[k] : result);
+        for(; i < n; ++i) result = Greatest ? (result < p[i] ? p[i] : result) : (p[i] < result ? p[i] : result);
+        return result;
+    }
+
+    /**
+     * Sums into L lanes of S, so floating point results may differ from a
+     * left-to-right sum in the last bits.
+     */
+    static inline __attribute__((always_inline)) S sum(const T *p, int n){
+        typedef S W __attribute__((vector_size(L * sizeof(S))));
+        W acc = W();
+        int i = 0;
+        for(; i + L <= n; i += L){
+            V a;
+            memcpy(&a, p + i, N);
+            acc += __builtin_convertvector(a, W);
+        }
+        S result = S();
+        for(int k=0; k<L; ++k) result += acc[k];
+        for(; i < n; ++i) result += p[i];
+        return result;
+    }
+};
+
+/**
+ * SimdScan<T> runs the searches and reductions of ArrayList over arithmetic
+ * element types with the widest vectors the CPU supports, picked once at
+ * run time. enabled is false for other types, which keep the scalar loops.
+ */
+template<class T>
+struct SimdScan
+{
+    static const bool enabled = std::is_arithmetic<T>::value && !std::is_same<T, bool>::value
+        && (sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8);
+    typedef typename SumOf<T>::Type S;
+
+    static int indexOf(const T *p, int n, const T &v){
+        switch(tier()){
+        case 2: return indexOf512(p, n, v);
+        case 1: return indexOf256(p, n, v);
+        default: return VectorScan<T, 16>::indexOf(p, n, v);
+        }
+    }
+
+    static int lastIndexOf(const T *p, int n, const T &v){
+        switch(tier()){
+        case 2: return lastIndexOf512(p, n, v);
+        case 1: return lastIndexOf256(p, n, v);
+        default: return VectorScan<T, 16>::lastIndexOf(p, n, v);
+        }
+    }
+
+    static int count(const T *p, int n, const T &v){
+        switch(tier()){
+        case 2: return count512(p, n, v);
+        case 1: return count256(p, n, v);
+        default: return VectorScan<T, 16>::count(p, n, v);
+        }
+    }
+
+    /**
+     * Least (or, if Greatest, greatest) of the n > 0 elements of p.
+     */
+    template<bool Greatest>
+    static T extreme(const T *p, int n){
+        switch(tier()){
+        case 2: return extreme512<Greatest>(p, n);
+        case 1: return extreme256<Greatest>(p, n);
+        default: return VectorScan<T, 16>::template extreme<Greatest>(p, n);
+        }
+    }
+
+    static S sum(const T *p, int n){
+        switch(tier()){
+        case 2: return sum512(p, n);
+        case 1: return sum256(p, n);
+        default: return VectorScan<T, 16>::sum(p, n);
+        }
+    }
+
+private:
+    /**
+     * 2 with AVX-512BW, 1 with AVX2, 0 with the SSE2 baseline.
+     */
+    static int tier(){
+        static const int level = __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") ? 2
+                               : __builtin_cpu_supports("avx2") ? 1 : 0;
+        return level;
+    }
+
+    __attribute__((target("avx2"))) static int indexOf256(const T *p, int n, T v){
+        return VectorScan<T, 32>::indexOf(p, n, v);
+    }
+    __attribute__((target("avx512f,avx512bw"))) static int indexOf512(const T *p, int n, T v){
+        return VectorScan<T, 64>::indexOf(p, n, v);
+    }
+    __attribute__((target("avx2"))) static int lastIndexOf256(const T *p, int n, T v){
+        return VectorScan<T, 32>::lastIndexOf(p, n, v);
+    }
+    __attribute__((target("avx512f,avx512bw"))) static int lastIndexOf512(const T *p, int n, T v){
+        return VectorScan<T, 64>::lastIndexOf(p, n, v);
+    }
+    __attribute__((target("avx2"))) static int count256(const T *p, int n, T v){
+        return VectorScan<T, 32>::count(p, n, v);
+    }
+    __attribute__((target("avx512f,avx512bw"))) static int count512(const T *p, int n, T v){
+        return VectorScan<T, 64>::count(p, n, v);
+    }
+    template<bool Greatest>
+    __attribute__((target("avx2"))) static T extreme256(const T *p, int n){
+        return VectorScan<T, 32>::template extreme<Greatest>(p, n);
+    }
+    template<bool Greatest>
+    __attribute__((target("avx512f,avx512bw"))) static T extreme512(const T *p, int n){
+        return VectorScan<T, 64>::template extreme<Greatest>(p, n);
+    }
+    __attribute__((target("avx2"))) static S sum256(const T *p, int n){
+        return VectorScan<T, 32>::sum(p, n);
+    }
+    __attribute__((target("avx512f,avx512bw"))) static S sum512(const T *p, int n){
+        return VectorScan<T, 64>::sum(p, n);
+    }
+};
+
+#else
+
+/**
+ * Without the GCC vector extensions on x86, every type keeps the scalar loops.
+ */
+template<class T>
+struct SimdScan
+{
+    static const bool enabled = false;
+};
+
+#endif
+
+#endif
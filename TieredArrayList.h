@@ -0,0 +1,460 @@
+/** @file */
+#ifndef __TIEREDARRAYLIST_H
+#define __TIEREDARRAYLIST_H
+
+#include <new>
+#include <utility>
+
+#include "IndexOutOfBound.h"
+#include "ElementNotExist.h"
+#include "ArrayList.h"
+
+/**
+ * TieredArrayList has the indexed API of ArrayList, but inserts and
+ * removes anywhere in O(sqrt(n)) instead of O(n).
+ *
+ * The elements are split into blocks of B slots, B a power of two near
+ * sqrt(n), each used as a circular buffer; every block but the last is
+ * full. get(i) is therefore two shifts and a mask away. An insertion
+ * shifts the shorter side of its own block, then moves one element from
+ * the back of each later block to the front of the next, which is O(1)
+ * per block thanks to the circular layout. Removal does the reverse. B is
+ * doubled or halved, and everything moved to the new layout, as the list
+ * grows past 2 * B * B or shrinks below B * B / 8 elements.
+ *
+ * Elements are moved between slots, so the move constructor of T should
+ * not throw.
+ *
+ * The iterator iterates in the order of the elements being loaded into this list
+ */
+template<class T>
+class TieredArrayList
+{
+private:
+    struct Block{
+        T *slots;
+        int head;
+    };
+
+    ArrayList<Block*> iBlocks;
+    Block *pSpare;
+    int iSize;
+    int iShift;
+
+    static const int iMinShift = 6;
+
+    int mask() const{
+        return (1 << iShift) - 1;
+    }
+
+    T *slot(const Block *block, int j) const{
+        return block->slots + ((block->head + j) & mask());
+    }
+
+    T *slot(int index) const{
+        return slot(iBlocks.get(index >> iShift), index & mask());
+    }
+
+    static void relocate(T *dst, T *src){
+        new(dst) T(std::move(*src));
+        src->~T();
+    }
+
+    /**
+     * A block of the current size, reusing the one freed last if there is one.
+     */
+    Block* newBlock(){
+        Block *block = pSpare;
+        if(block != NULL) pSpare = NULL;
+        else {
+            block = new Block;
+            try{
+                block->slots = static_cast<T*>(::operator new(sizeof(T) << iShift));
+            }
+            catch(...){
+                delete block;
+                throw;
+            }
+        }
+        block->head = 0;
+        return block;
+    }
+
+    static void deleteBlock(Block *block){
+        if(block == NULL) return;
+        ::operator delete(block->slots);
+        delete block;
+    }
+
+    void freeBlock(Block *block){
+        deleteBlock(pSpare);
+        pSpare = block;
+    }
+
+    /**
+     * Moves every element into blocks of 1 << shift slots.
+     */
+    void rebuild(int shift){
+        ArrayList<Block*> blocks;
+        int oldShift = iShift;
+        deleteBlock(pSpare);
+        pSpare = NULL;
+        iShift = shift;
+        try{
+            blocks.reserve((iSize + mask()) >> iShift);
+            for(int i=0; i<iSize; i+=1<<iShift) blocks.add(newBlock());
+        }
+        catch(...){
+            for(int k=0; k<blocks.size(); ++k) deleteBlock(blocks.get(k));
+            iShift = oldShift;
+            throw;
+        }
+        for(int i=0; i<iSize; ++i){
+            int mOld = (1 << oldShift) - 1;
+            const Block *src = iBlocks.get(i >> oldShift);
+            relocate(blocks.get(i >> iShift)->slots + (i & mask()), src->slots + ((src->head + (i & mOld)) & mOld));
+        }
+        for(int k=0; k<iBlocks.size(); ++k) deleteBlock(iBlocks.get(k));
+        iBlocks = std::move(blocks);
+    }
+
+    /**
+     * Makes room for one more element at the end of the last block.
+     */
+    void makeRoom(){
+        if(static_cast<long long>(iSize) + 1 > 2LL << (2 * iShift)) rebuild(iShift + 1);
+        if(iSize == iBlocks.size() << iShift) iBlocks.add(newBlock());
+    }
+
+    void shrinkIfSparse(){
+        if(iShift > iMinShift && static_cast<long long>(iSize) * 8 < 1LL << (2 * iShift))
+            rebuild(iShift - 1);
+    }
+
+    void append(T&& element){
+        makeRoom();
+        new(slot(iBlocks.get(iBlocks.size() - 1), iSize & mask())) T(std::move(element));
+        ++iSize;
+    }
+
+    void copyFrom(const TieredArrayList& x){
+        iShift = x.iShift;
+        iBlocks.reserve(x.iBlocks.size());
+        for(int i=0; i<x.iSize; ++i) append(T(x.get(i)));
+    }
+
+public:
+    class Iterator
+    {
+    private:
+        int position;
+        TieredArrayList *pArray;
+        bool ifPointed;
+    public:
+        Iterator(TieredArrayList *parArray)
+        :position(0),pArray(parArray),ifPointed(false){}
+        /**
+         * Returns true if the iteration has more elements.
+         */
+        bool hasNext() {
+            if(position < pArray->iSize - 1) return true;
+            if((!ifPointed) && (position == pArray->iSize - 1)) return true;
+            return false;
+        }
+
+        /**
+         * Returns the next element in the iteration.
+         * @throw ElementNotExist exception when hasNext() == false
+         */
+        const T &next() {
+            if(!hasNext()) throw ElementNotExist();
+            if(ifPointed) ++position;
+            else ifPointed = true;
+            return *pArray->slot(position);
+        }
+
+        /**
+         * Removes from the underlying collection the last element returned
+         * by the iterator.
+         * @throw ElementNotExist
+         */
+        void remove() {
+            if(!ifPointed) throw ElementNotExist();
+            pArray->removeIndex(position);
+            ifPointed = false;
+        }
+    };
+
+    /**
+     *  Constructs an empty list. Nothing is allocated until the first add.
+     */
+    TieredArrayList()
+    :pSpare(NULL),iSize(0),iShift(iMinShift){}
+
+    /**
+     *  Destructor
+     */
+    ~TieredArrayList() {
+        clear();
+        deleteBlock(pSpare);
+    }
+
+    /**
+     *  Copy-constructor
+     */
+    TieredArrayList(const TieredArrayList& x)
+    :pSpare(NULL),iSize(0),iShift(iMinShift) {
+        try{
+            copyFrom(x);
+        }
+        catch(...){
+            clear();
+            deleteBlock(pSpare);
+            throw;
+        }
+    }
+
+    /**
+     *  Move-constructor. x is left empty.
+     */
+    TieredArrayList(TieredArrayList&& x) noexcept
+    :iBlocks(std::move(x.iBlocks)),pSpare(x.pSpare),iSize(x.iSize),iShift(x.iShift) {
+        x.pSpare = NULL;
+        x.iSize = 0;
+        x.iShift = iMinShift;
+    }
+
+    /**
+     *  Assignment operator
+     */
+    TieredArrayList& operator=(const TieredArrayList& x) {
+        if(this == &x) return *this;
+        TieredArrayList tmp(x);
+        swap(tmp);
+        return *this;
+    }
+
+    /**
+     *  Move assignment operator. x is left empty.
+     */
+    TieredArrayList& operator=(TieredArrayList&& x) noexcept {
+        if(this == &x) return *this;
+        TieredArrayList tmp(std::move(x));
+        swap(tmp);
+        return *this;
+    }
+
+    /**
+     *  Exchanges the contents of this list and x in O(1).
+     */
+    void swap(TieredArrayList& x) noexcept {
+        iBlocks.swap(x.iBlocks);
+        std::swap(pSpare, x.pSpare);
+        std::swap(iSize, x.iSize);
+        std::swap(iShift, x.iShift);
+    }
+
+    /**
+     *  Appends the specified element to the end of this list.
+     * Always returns true.
+     */
+    bool add(const T& e) {
+        append(T(e));
+        return true;
+    }
+
+    /**
+     *  Appends the specified element to the end of this list, moving it in.
+     * Always returns true.
+     */
+    bool add(T&& e) {
+        append(std::move(e));
+        return true;
+    }
+
+    /**
+     *  Inserts the specified element to the specified position in this list.
+     * The range of index parameter is [0, size], where index=0 means inserting to the head,
+     * and index=size means appending to the end.
+     * @throw IndexOutOfBound
+     */
+    void add(int index, const T& element) {
+        if(index < 0 || index > iSize) throw IndexOutOfBound();
+        add(index, T(element));
+    }
+
+    /**
+     *  Inserts the specified element to the specified position in this list, moving it in.
+     * @throw IndexOutOfBound
+     */
+    void add(int index, T&& element) {
+        if(index < 0 || index > iSize) throw IndexOutOfBound();
+        if(index == iSize){
+            append(std::move(element));
+            return;
+        }
+        makeRoom();
+        int b = index >> iShift, last = iBlocks.size() - 1;
+        for(int k=last; k>b; --k){
+            Block *dst = iBlocks.get(k);
+            dst->head = (dst->head - 1) & mask();
+            relocate(slot(dst, 0), slot(iBlocks.get(k - 1), mask()));
+        }
+        Block *block = iBlocks.get(b);
+        int cnt = b == last ? iSize - (b << iShift) : mask();
+        int o = index & mask();
+        if(o < cnt - o){
+            block->head = (block->head - 1) & mask();
+            for(int j=0; j<o; ++j) relocate(slot(block, j), slot(block, j + 1));
+        }
+        else {
+            for(int j=cnt; j>o; --j) relocate(slot(block, j), slot(block, j - 1));
+        }
+        new(slot(block, o)) T(std::move(element));
+        ++iSize;
+    }
+
+    /**
+     *  Removes all of the elements from this list.
+     */
+    void clear() {
+        for(int i=0; i<iSize; ++i) slot(i)->~T();
+        for(int k=0; k<iBlocks.size(); ++k) deleteBlock(iBlocks.get(k));
+        deleteBlock(pSpare);
+        pSpare = NULL;
+        iBlocks.clear();
+        iSize = 0;
+        iShift = iMinShift;
+    }
+
+    /**
+     *  Returns true if this list contains the specified element.
+     */
+    bool contains(const T& e) const {
+        return indexOf(e) >= 0;
+    }
+
+    /**
+     *  Returns the index of the first occurrence of the specified element, or -1.
+     */
+    int indexOf(const T& e) const {
+        for(int i=0; i<iSize; ++i)
+            if(*slot(i) == e)
+                return i;
+        return -1;
+    }
+
+    /**
+     *  Returns a const reference to the element at the specified position in this list.
+     * The index is zero-based, with range [0, size).
+     * @throw IndexOutOfBound
+     */
+    const T& get(int index) const {
+        if(index < 0 || index >= iSize) throw IndexOutOfBound();
+        return *slot(index);
+    }
+
+    /**
+     *  Copies the element at the specified position into element and returns true,
+     * or returns false and leaves element untouched if the index is out of range.
+     */
+    bool tryGet(int index, T& element) const {
+        if(index < 0 || index >= iSize) return false;
+        element = *slot(index);
+        return true;
+    }
+
+    /**
+     *  Returns the element at the specified position, or defaultValue if the
+     * index is out of range.
+     */
+    T getOrDefault(int index, const T& defaultValue) const {
+        if(index < 0 || index >= iSize) return defaultValue;
+        return *slot(index);
+    }
+
+    /**
+     *  Returns true if this list contains no elements.
+     */
+    bool isEmpty() const {
+        return !iSize;
+    }
+
+    /**
+     *  Removes the element at the specified position in this list.
+     * The index is zero-based, with range [0, size).
+     * @throw IndexOutOfBound
+     */
+    void removeIndex(int index) {
+        if(index < 0 || index >= iSize) throw IndexOutOfBound();
+        int b = index >> iShift, last = iBlocks.size() - 1;
+        Block *block = iBlocks.get(b);
+        int cnt = b == last ? iSize - (b << iShift) : mask() + 1;
+        int o = index & mask();
+        slot(block, o)->~T();
+        if(o < cnt - 1 - o){
+            for(int j=o; j>0; --j) relocate(slot(block, j), slot(block, j - 1));
+            block->head = (block->head + 1) & mask();
+        }
+        else {
+            for(int j=o; j<cnt-1; ++j) relocate(slot(block, j), slot(block, j + 1));
+        }
+        for(int k=b+1; k<=last; ++k){
+            Block *src = iBlocks.get(k);
+            relocate(slot(iBlocks.get(k - 1), mask()), slot(src, 0));
+            src->head = (src->head + 1) & mask();
+        }
+        --iSize;
+        if(iSize == last << iShift){
+            freeBlock(iBlocks.get(last));
+            iBlocks.removeIndex(last);
+        }
+        shrinkIfSparse();
+    }
+
+    /**
+     *  Removes the first occurrence of the specified element from this list, if it is present.
+     * Returns true if it was present in the list, otherwise false.
+     */
+    bool remove(const T &e) {
+        int p = indexOf(e);
+        if(p < 0) return false;
+        removeIndex(p);
+        return true;
+    }
+
+    /**
+     *  Replaces the element at the specified position in this list with the specified element.
+     * The index is zero-based, with range [0, size).
+     * @throw IndexOutOfBound
+     */
+    void set(int index, const T &element) {
+        if(index < 0 || index >= iSize) throw IndexOutOfBound();
+        *slot(index) = element;
+    }
+
+    /**
+     *  Replaces the element at the specified position in this list, moving the new one in.
+     * @throw IndexOutOfBound
+     */
+    void set(int index, T &&element) {
+        if(index < 0 || index >= iSize) throw IndexOutOfBound();
+        *slot(index) = std::move(element);
+    }
+
+    /**
+     *  Returns the number of elements in this list.
+     */
+    int size() const {
+        return iSize;
+    }
+
+    /**
+     *  Returns an iterator over the elements in this list.
+     */
+    Iterator iterator() {
+        return Iterator(this);
+    }
+};
+
+#endif
@@ -3,14 +3,25 @@
 #define __TREEMAP_H
 #include <cstdlib>
 #include <ctime>
+#include <thread>
+#include <utility>
 
 #include "ElementNotExist.h"
+#include "IndexOutOfBound.h"
+#include "Aggregate.h"
+#include "NodePool.h"
 
 /**
  * TreeMap is the balanced-tree implementation of map. The iterators must
  * iterate through the map in the natural order (operator<) of the key.
+ *
+ * The optional policy A (see Aggregate.h) makes every node cache the
+ * aggregate of the values in its subtree, so aggregate(lo, hi) takes
+ * O(log n) instead of a scan of the range.
+ *
+ * Nodes come from Alloc, a NodePool of this map by default (see NodePool.h).
  */
-template<class K, class V>
+template<class K, class V, class A = NoAggregate<V>, template<class> class Alloc = NodePool>
 class TreeMap
 {
 public:
@@ -40,75 +51,127 @@ public:
         }
     };
     
-    struct TreapNode{
+    typedef typename A::Type Aggregate;
+
+    struct TreapNode : AggregateSlot<Aggregate>{
         TreapNode* lf;
         TreapNode* rt;
+        TreapNode* pa;
         Entry data;
         int fix;
+        int sz;
         TreapNode(const K& k, const V& v)
-        :data(k,v),fix(rand()),lf(NULL),rt(NULL){}
+        :lf(NULL),rt(NULL),pa(NULL),data(k,v),fix(rand()),sz(1){
+            this->setAggregate(A::lift(v));
+        }
+        TreapNode(const K& k, const V& v, int parFix)
+        :lf(NULL),rt(NULL),pa(NULL),data(k,v),fix(parFix),sz(1){
+            this->setAggregate(A::lift(v));
+        }
     };
     
 private:
+    typedef Alloc<TreapNode> Pool;
     TreapNode *TreapRoot;
     int iSize;
+    Pool iPool;
+    static int sizeOf(const TreapNode *root){
+        return root == NULL ? 0 : root->sz;
+    }
+    static Aggregate aggregateOf(const TreapNode *root){
+        return root == NULL ? A::identity() : root->getAggregate();
+    }
+    /**
+     * Recomputes the subtree size and aggregate of root from its children.
+     */
+    static void pull(TreapNode *root){
+        root->sz = sizeOf(root->lf) + sizeOf(root->rt) + 1;
+        root->setAggregate(A::combine(A::combine(aggregateOf(root->lf), A::lift(root->data.getValue())), aggregateOf(root->rt)));
+    }
+    /**
+     * Recomputes node and all of its ancestors, after a change below them.
+     */
+    static void pullUp(TreapNode *node){
+        for(; node != NULL; node = node->pa) pull(node);
+    }
     void rot_lf(TreapNode *&root){
         TreapNode *tmp = root->rt;
         root->rt = tmp->lf;
+        if(tmp->lf != NULL) tmp->lf->pa = root;
         tmp->lf = root;
+        tmp->pa = root->pa;
+        root->pa = tmp;
+        pull(root);
+        pull(tmp);
         root = tmp;
     }
     void rot_rt(TreapNode *&root){
         TreapNode *tmp = root->lf;
         root->lf = tmp->rt;
+        if(tmp->rt != NULL) tmp->rt->pa = root;
         tmp->rt = root;
+        tmp->pa = root->pa;
+        root->pa = tmp;
+        pull(root);
+        pull(tmp);
         root = tmp;
     }
-    void insert(const K& key,const V& value,TreapNode *&root){
+    /**
+     * Returns the pointer that links node into the tree.
+     */
+    TreapNode*& slotOf(TreapNode *node){
+        if(node->pa == NULL) return TreapRoot;
+        return node->pa->lf == node ? node->pa->lf : node->pa->rt;
+    }
+    /**
+     * Returns the node of key below root. If there is none, a node holding
+     * make(key) is inserted and inserted is set to true.
+     */
+    template<class F>
+    TreapNode* locate(const K& key,F& make,TreapNode *&root,bool& inserted){
         if(root == NULL){
-            root = new TreapNode(key,value);
+            root = newNode<TreapNode>(iPool,key,make(key));
             ++iSize;
-            return;
+            inserted = true;
+            return root;
         }
-        else if (root->data.getKey() == key) root->data.setValue(value);
+        else if (root->data.getKey() == key) return root;
         else if (key < root->data.getKey()){
-            insert(key,value,root->lf);
+            TreapNode *tmp = locate(key,make,root->lf,inserted);
+            root->lf->pa = root;
             if(root->lf->fix > root->fix) rot_rt(root);
+            else pull(root);
+            return tmp;
         }
         else {
-            insert(key,value,root->rt);
+            TreapNode *tmp = locate(key,make,root->rt,inserted);
+            root->rt->pa = root;
             if(root->rt->fix > root->fix) rot_lf(root);
+            else pull(root);
+            return tmp;
         }
     }
+
+    struct ValueMaker{
+        const V& value;
+        ValueMaker(const V& v):value(v){}
+        const V& operator()(const K&) const { return value; }
+    };
     
-    bool remove(const K& key,TreapNode *&root){
-        if(root == NULL) return false;
-        else if (key < root->data.getKey()) return remove(key, root->lf);
-        else if (key > root->data.getKey()) return remove(key, root->rt);
-        else{
-            if(root->rt == NULL){
-                TreapNode *tmp = root;
-                root = root->lf;
-                delete tmp;
-                --iSize;
-                return true;
-            }
-            else if(root->lf == NULL){
-                TreapNode *tmp = root;
-                root = root->rt;
-                delete tmp;
-                --iSize;
-                return true;
-            }
-            else if(root->lf->fix > root->rt->fix){
-                rot_rt(root);
-                return remove(key,root->rt);
-            }
-            else {
-                rot_lf(root);
-                return remove(key,root->lf);
-            }
+    /**
+     * Rotates node down until it has at most one child, then splices it out.
+     */
+    void removeNode(TreapNode *node){
+        while(node->lf != NULL && node->rt != NULL){
+            if(node->lf->fix > node->rt->fix) rot_rt(slotOf(node));
+            else rot_lf(slotOf(node));
         }
+        TreapNode *&slot = slotOf(node);
+        slot = node->lf != NULL ? node->lf : node->rt;
+        if(slot != NULL) slot->pa = node->pa;
+        pullUp(node->pa);
+        deleteNode(iPool,node);
+        --iSize;
     }
     
     const V& get(const K& key,TreapNode *root) const{
@@ -118,6 +181,13 @@ private:
         else return root->data.getValue();
     }
     
+    TreapNode* lookup(const K& key, TreapNode *root) const{
+        if(root == NULL) return NULL;
+        if(key < root->data.getKey()) return lookup(key,root->lf);
+        if(key > root->data.getKey()) return lookup(key,root->rt);
+        return root;
+    }
+
     bool contain(const K& key, TreapNode *root) const{
         if(root == NULL) return false;
         if(key < root->data.getKey()) return contain(key,root->lf);
@@ -131,16 +201,192 @@ private:
         removeTree(root->rt);
         TreapNode *tmp = root;
         root = NULL;
-        delete tmp;
+        deleteNode(iPool,tmp);
+    }
+
+    /**
+     * Destroys every node and gives the pool's memory back. Nodes with
+     * nothing to destroy are not visited when the pool frees them anyway.
+     */
+    void releaseNodes(){
+        if(!CanDropNodes<TreapNode, Pool>::value) removeTree(TreapRoot);
+        TreapRoot = NULL;
+        iPool.releaseAll();
+    }
+
+    /**
+     * Subtrees with fewer nodes than this are never handed to another thread.
+     */
+    static const int iParallelCutoff = 1 << 14;
+
+    static void setChildren(TreapNode *root, TreapNode *lf, TreapNode *rt){
+        root->lf = lf;
+        root->rt = rt;
+        if(lf != NULL) lf->pa = root;
+        if(rt != NULL) rt->pa = root;
+        pull(root);
+    }
+
+    /**
+     * Splits root into l, holding the keys less than key (or not greater
+     * than key, if inclusive), and r, holding the rest.
+     */
+    static void split(TreapNode *root, const K& key, bool inclusive, TreapNode *&l, TreapNode *&r){
+        if(root == NULL){
+            l = r = NULL;
+            return;
+        }
+        if(root->data.getKey() < key || (inclusive && !(key < root->data.getKey()))){
+            split(root->rt, key, inclusive, root->rt, r);
+            if(root->rt != NULL) root->rt->pa = root;
+            l = root;
+        }
+        else {
+            split(root->lf, key, inclusive, l, root->lf);
+            if(root->lf != NULL) root->lf->pa = root;
+            r = root;
+        }
+        pull(root);
+        if(l != NULL) l->pa = NULL;
+        if(r != NULL) r->pa = NULL;
+    }
+
+    /**
+     * Joins two treaps where every key of a is less than every key of b.
+     */
+    static TreapNode* merge(TreapNode *a, TreapNode *b){
+        if(a == NULL) return b;
+        if(b == NULL) return a;
+        if(a->fix > b->fix){
+            setChildren(a, a->lf, merge(a->rt, b));
+            return a;
+        }
+        setChildren(b, merge(a, b->lf), b->rt);
+        return b;
+    }
+
+    /**
+     * Splits a around the key of b and runs op on the parts below and above
+     * it against the children of b. The two halves touch disjoint nodes, so
+     * the lower one goes to another thread while the thread budget and the
+     * subtree sizes allow it. Returns the node of a holding b's key, if any.
+     * The other thread allocates and frees through a pool of its own, which
+     * pool takes over once it is done.
+     */
+    template<class Op>
+    static TreapNode* forkJoin(Op op, Pool &pool, TreapNode *a, const TreapNode *b, int threads, TreapNode *&l, TreapNode *&r){
+        bool parallel = threads > 1 && sizeOf(a) + sizeOf(b) >= iParallelCutoff;
+        TreapNode *mid, *rest;
+        split(a, b->data.getKey(), false, l, rest);
+        split(rest, b->data.getKey(), true, mid, r);
+        if(parallel){
+            TreapNode *lf = l;
+            Pool lower;
+            std::thread worker([&]{ l = op(lower, lf, b->lf, threads / 2); });
+            r = op(pool, r, b->rt, threads - threads / 2);
+            worker.join();
+            pool.adopt(lower);
+        }
+        else {
+            l = op(pool, l, b->lf, 1);
+            r = op(pool, r, b->rt, 1);
+        }
+        return mid;
+    }
+
+    /**
+     * Returns a with every mapping of b put into it. b is only read.
+     */
+    static TreapNode* unite(Pool &pool, TreapNode *a, const TreapNode *b, int threads){
+        if(b == NULL) return a;
+        TreapNode *l, *r;
+        TreapNode *mid = forkJoin(unite, pool, a, b, threads, l, r);
+        if(mid == NULL) mid = newNode<TreapNode>(pool, b->data.getKey(), b->data.getValue(), b->fix);
+        else mid->data.setValue(b->data.getValue());
+        setChildren(mid, NULL, NULL);
+        return merge(merge(l, mid), r);
+    }
+
+    /**
+     * Returns a with every key that is not in b removed. b is only read.
+     */
+    static TreapNode* intersect(Pool &pool, TreapNode *a, const TreapNode *b, int threads){
+        if(a == NULL) return NULL;
+        if(b == NULL){
+            removeSubtree(pool, a);
+            return NULL;
+        }
+        TreapNode *l, *r;
+        TreapNode *mid = forkJoin(intersect, pool, a, b, threads, l, r);
+        if(mid != NULL) setChildren(mid, NULL, NULL);
+        return merge(merge(l, mid), r);
+    }
+
+    /**
+     * Returns a with every key of b removed. b is only read.
+     */
+    static TreapNode* subtract(Pool &pool, TreapNode *a, const TreapNode *b, int threads){
+        if(a == NULL || b == NULL) return a;
+        TreapNode *l, *r;
+        deleteNode(pool, forkJoin(subtract, pool, a, b, threads, l, r));
+        return merge(l, r);
+    }
+
+    /**
+     * Aggregate of the keys of root that are not less than lo.
+     */
+    static Aggregate aggregateFrom(const TreapNode *root, const K& lo){
+        Aggregate result = A::identity();
+        while(root != NULL){
+            if(root->data.getKey() < lo) root = root->rt;
+            else {
+                result = A::combine(A::combine(A::lift(root->data.getValue()), aggregateOf(root->rt)), result);
+                root = root->lf;
+            }
+        }
+        return result;
+    }
+
+    /**
+     * Aggregate of the keys of root that are less than hi.
+     */
+    static Aggregate aggregateBelow(const TreapNode *root, const K& hi){
+        Aggregate result = A::identity();
+        while(root != NULL){
+            if(root->data.getKey() < hi){
+                result = A::combine(result, A::combine(aggregateOf(root->lf), A::lift(root->data.getValue())));
+                root = root->rt;
+            }
+            else root = root->lf;
+        }
+        return result;
+    }
+
+    static void removeSubtree(Pool &pool, TreapNode *root){
+        if(root == NULL) return;
+        removeSubtree(pool, root->lf);
+        removeSubtree(pool, root->rt);
+        deleteNode(pool, root);
+    }
+
+    static void pullAll(TreapNode *root){
+        if(root == NULL) return;
+        pullAll(root->lf);
+        pullAll(root->rt);
+        pull(root);
     }
     
 public:
     void copyTree(TreapNode *&destination, const TreapNode *source){
         if(source == NULL) return;
-        destination = new TreapNode(source->data.getKey(),source->data.getValue());
+        destination = newNode<TreapNode>(iPool,source->data.getKey(),source->data.getValue());
         destination->fix = source->fix;
+        destination->sz = source->sz;
+        destination->setAggregate(source->getAggregate());
         copyTree(destination->lf,source->lf);
         copyTree(destination->rt,source->rt);
+        if(destination->lf != NULL) destination->lf->pa = destination;
+        if(destination->rt != NULL) destination->rt->pa = destination;
     }
     
     TreapNode* findNode(const K& key, TreapNode *root) const{
@@ -158,23 +404,94 @@ public:
         if(root->lf != NULL) return findMin(root->lf);
         return root;
     }
+
+    TreapNode* findMax(TreapNode *root) const{
+        if(root == NULL) return NULL;
+        if(root->rt != NULL) return findMax(root->rt);
+        return root;
+    }
+
+    /**
+     * Returns the in-order successor of node, or NULL if node is the last one.
+     */
+    static TreapNode* successor(TreapNode *node){
+        if(node->rt != NULL){
+            node = node->rt;
+            while(node->lf != NULL) node = node->lf;
+            return node;
+        }
+        while(node->pa != NULL && node->pa->rt == node) node = node->pa;
+        return node->pa;
+    }
+
+    /**
+     * Returns the in-order predecessor of node, or NULL if node is the first one.
+     */
+    static TreapNode* predecessor(TreapNode *node){
+        if(node->lf != NULL){
+            node = node->lf;
+            while(node->rt != NULL) node = node->rt;
+            return node;
+        }
+        while(node->pa != NULL && node->pa->lf == node) node = node->pa;
+        return node->pa;
+    }
+
+    /**
+     * Returns the node with the least key not less than key (or, if strict,
+     * greater than key), or NULL if there is none.
+     */
+    TreapNode* ceilingNode(const K& key, bool strict) const{
+        TreapNode *best = NULL;
+        for(TreapNode *root = TreapRoot; root != NULL;){
+            if(key < root->data.getKey() || (!strict && !(root->data.getKey() < key))){
+                best = root;
+                root = root->lf;
+            }
+            else root = root->rt;
+        }
+        return best;
+    }
+
+    /**
+     * Returns the node with the greatest key not greater than key (or, if
+     * strict, less than key), or NULL if there is none.
+     */
+    TreapNode* floorNode(const K& key, bool strict) const{
+        TreapNode *best = NULL;
+        for(TreapNode *root = TreapRoot; root != NULL;){
+            if(root->data.getKey() < key || (!strict && !(key < root->data.getKey()))){
+                best = root;
+                root = root->rt;
+            }
+            else root = root->lf;
+        }
+        return best;
+    }
     
-    class Iterator
+    /**
+     * Iterates in ascending key order, or in descending order when obtained
+     * through descendingIterator(). Each step follows parent links from the
+     * current node, so a full iteration costs O(n). This is what a const map
+     * hands out; Iterator adds remove().
+     */
+    class ConstIterator
     {
-    private:
-        const TreeMap *pTreeMap;
-        bool flag;
-        K key;
+    protected:
+        TreapNode *pNext;
+        TreapNode *pLast;
+        bool descending;
     public:
-        Iterator(const TreeMap* parTreeMap)
-        :pTreeMap(parTreeMap),flag(false){}
+        ConstIterator(const TreeMap* parTreeMap, bool parDescending = false)
+        :pLast(NULL),descending(parDescending){
+            pNext = descending ? parTreeMap->findMax(parTreeMap->TreapRoot) : parTreeMap->findMin(parTreeMap->TreapRoot);
+        }
         /**
          * TODO Returns true if the iteration has more elements.
          */
         bool hasNext() {
-            if (pTreeMap->TreapRoot == NULL) return false;
-            return (!flag || pTreeMap->findNode(key, pTreeMap->TreapRoot) != NULL);
-            }
+            return pNext != NULL;
+        }
         
         /**
          * TODO Returns the next element in the iteration.
@@ -182,12 +499,167 @@ public:
          */
         const Entry &next() {
             if(!hasNext()) throw ElementNotExist();
-            TreapNode *tmp;
-            if(!flag) tmp = pTreeMap->findMin(pTreeMap->TreapRoot);
-            else tmp = pTreeMap->findNode(key,pTreeMap->TreapRoot);
-            key = tmp->data.getKey();
-            flag = true;
-            return tmp->data;
+            pLast = pNext;
+            pNext = descending ? predecessor(pNext) : successor(pNext);
+            return pLast->data;
+        }
+    };
+
+    /**
+     * A ConstIterator over a mutable map, which may also remove entries.
+     */
+    class Iterator : public ConstIterator
+    {
+    private:
+        TreeMap *pTreeMap;
+    public:
+        Iterator(TreeMap* parTreeMap, bool parDescending = false)
+        :ConstIterator(parTreeMap, parDescending),pTreeMap(parTreeMap){}
+
+        /**
+         * Removes from the underlying map the last element returned by the
+         * iterator. The iteration may continue afterwards.
+         * @throw ElementNotExist
+         */
+        void remove() {
+            if(this->pLast == NULL) throw ElementNotExist();
+            pTreeMap->removeNode(this->pLast);
+            this->pLast = NULL;
+        }
+    };
+
+    /**
+     * A live view of the keys of a TreeMap in the range [lo, hi), where
+     * either bound may be absent. The view copies nothing: every query
+     * seeks into the backing map in O(log n), and its iterator streams the
+     * range in key order, so later changes to the map show through it.
+     */
+    class SubMap
+    {
+    private:
+        const TreeMap *pTreeMap;
+        K lo;
+        K hi;
+        bool hasLo;
+        bool hasHi;
+
+        bool aboveLo(const K& key) const {
+            return !hasLo || !(key < lo);
+        }
+        bool belowHi(const K& key) const {
+            return !hasHi || key < hi;
+        }
+        bool inRange(const K& key) const {
+            return aboveLo(key) && belowHi(key);
+        }
+        TreapNode* first() const {
+            TreapNode *tmp = hasLo ? pTreeMap->ceilingNode(lo, false) : pTreeMap->findMin(pTreeMap->TreapRoot);
+            return (tmp != NULL && belowHi(tmp->data.getKey())) ? tmp : NULL;
+        }
+        TreapNode* last() const {
+            TreapNode *tmp = hasHi ? pTreeMap->floorNode(hi, true) : pTreeMap->findMax(pTreeMap->TreapRoot);
+            return (tmp != NULL && aboveLo(tmp->data.getKey())) ? tmp : NULL;
+        }
+    public:
+        /**
+         * Keeps its own copy of the upper bound, so it stays valid after the
+         * view it came from is gone, as with m.subMap(lo, hi).iterator().
+         */
+        class Iterator
+        {
+        private:
+            TreapNode *pNext;
+            K hi;
+            bool hasHi;
+        public:
+            Iterator(const SubMap* parSubMap)
+            :pNext(parSubMap->first()),hi(parSubMap->hi),hasHi(parSubMap->hasHi){}
+            /**
+             * Returns true if the iteration has more elements.
+             */
+            bool hasNext() {
+                return pNext != NULL;
+            }
+
+            /**
+             * Returns the next element in the iteration.
+             * @throw ElementNotExist exception when hasNext() == false
+             */
+            const Entry &next() {
+                if(!hasNext()) throw ElementNotExist();
+                TreapNode *tmp = pNext;
+                pNext = successor(pNext);
+                if(pNext != NULL && hasHi && !(pNext->data.getKey() < hi)) pNext = NULL;
+                return tmp->data;
+            }
+        };
+
+        SubMap(const TreeMap *parTreeMap, const K* parLo, const K* parHi)
+        :pTreeMap(parTreeMap),hasLo(parLo != NULL),hasHi(parHi != NULL){
+            if(hasLo) lo = *parLo;
+            if(hasHi) hi = *parHi;
+        }
+
+        /**
+         * Returns an iterator over the elements of this view in key order.
+         */
+        Iterator iterator() const {
+            return Iterator(this);
+        }
+
+        /**
+         * Returns true if key is in range and mapped in the backing map.
+         */
+        bool containsKey(const K &key) const {
+            return inRange(key) && pTreeMap->containsKey(key);
+        }
+
+        /**
+         * Returns the entry mapped to key, or NULL if the key is out of range
+         * or not present.
+         */
+        const Entry *find(const K &key) const {
+            return inRange(key) ? pTreeMap->find(key) : NULL;
+        }
+
+        /**
+         * Returns a const reference to the value to which the specified key is mapped.
+         * @throw ElementNotExist if the key is out of range or not present
+         */
+        const V &get(const K &key) const {
+            if(!inRange(key)) throw ElementNotExist();
+            return pTreeMap->get(key);
+        }
+
+        /**
+         * Returns the entry with the least key in range, or NULL if the view is empty.
+         */
+        const Entry *firstEntry() const {
+            TreapNode *tmp = first();
+            return tmp == NULL ? NULL : &tmp->data;
+        }
+
+        /**
+         * Returns the entry with the greatest key in range, or NULL if the view is empty.
+         */
+        const Entry *lastEntry() const {
+            TreapNode *tmp = last();
+            return tmp == NULL ? NULL : &tmp->data;
+        }
+
+        /**
+         * Returns true if no key of the backing map is in range.
+         */
+        bool isEmpty() const {
+            return first() == NULL;
+        }
+
+        /**
+         * Returns the number of mappings in range in O(log n).
+         */
+        int size() const {
+            int cnt = (hasHi ? pTreeMap->rank(hi) : pTreeMap->iSize) - (hasLo ? pTreeMap->rank(lo) : 0);
+            return cnt > 0 ? cnt : 0;
         }
     };
     
@@ -195,13 +667,13 @@ public:
      * TODO Constructs an empty tree map.
      */
     TreeMap()
-    :iSize(0),TreapRoot(NULL){}
+    :TreapRoot(NULL),iSize(0){}
     
     /**
      * TODO Destructor
      */
     ~TreeMap() {
-        removeTree(TreapRoot);
+        releaseNodes();
     }
     
     /**
@@ -209,7 +681,7 @@ public:
      */
     TreeMap &operator=(const TreeMap &x) {
         if(this == &x) return *this;
-        removeTree(TreapRoot);
+        releaseNodes();
         iSize = x.iSize;
         copyTree(TreapRoot,x.TreapRoot);
         return *this;
@@ -219,22 +691,106 @@ public:
      * TODO Copy-constructor
      */
     TreeMap(const TreeMap &x)
-    :iSize(x.iSize),TreapRoot(NULL) {
+    :TreapRoot(NULL),iSize(x.iSize) {
         copyTree(TreapRoot,x.TreapRoot);
     }
+
+    /**
+     * Move-constructor. x is left empty.
+     */
+    TreeMap(TreeMap &&x)
+    :TreapRoot(x.TreapRoot),iSize(x.iSize),iPool(std::move(x.iPool)) {
+        x.TreapRoot = NULL;
+        x.iSize = 0;
+    }
+
+    /**
+     * Move assignment operator. x is left empty.
+     */
+    TreeMap &operator=(TreeMap &&x) {
+        if(this == &x) return *this;
+        releaseNodes();
+        iPool = std::move(x.iPool);
+        TreapRoot = x.TreapRoot;
+        iSize = x.iSize;
+        x.TreapRoot = NULL;
+        x.iSize = 0;
+        return *this;
+    }
+
+    /**
+     * Builds a map from the entries in [begin, end) in O(n). Each element
+     * must provide getKey() and getValue(), like Entry does, and the keys
+     * should be ascending; of equal neighbouring keys the last one wins.
+     * Elements that break the order are still accepted but cost a put each.
+     */
+    template<class Iter>
+    static TreeMap fromSorted(Iter begin, Iter end){
+        TreeMap result;
+        TreapNode *last = NULL;
+        for(; begin != end; ++begin){
+            if(last != NULL && !(last->data.getKey() < begin->getKey())){
+                if(!(begin->getKey() < last->data.getKey())){
+                    last->data.setValue(begin->getValue());
+                    continue;
+                }
+                break;
+            }
+            TreapNode *tmp = newNode<TreapNode>(result.iPool, begin->getKey(), begin->getValue());
+            TreapNode *child = NULL;
+            while(last != NULL && last->fix < tmp->fix){
+                child = last;
+                last = last->pa;
+            }
+            tmp->lf = child;
+            if(child != NULL) child->pa = tmp;
+            if(last != NULL){
+                last->rt = tmp;
+                tmp->pa = last;
+            }
+            else result.TreapRoot = tmp;
+            last = tmp;
+            ++result.iSize;
+        }
+        pullAll(result.TreapRoot);
+        for(; begin != end; ++begin) result.put(begin->getKey(), begin->getValue());
+        return result;
+    }
     /**
      * TODO Returns an iterator over the elements in this map.
      */
-    Iterator iterator() const {
+    Iterator iterator() {
         return Iterator(this);
     }
+
+    /**
+     * Returns a read-only iterator over the elements in this map.
+     */
+    ConstIterator iterator() const {
+        return ConstIterator(this);
+    }
+
+    /**
+     * Returns an iterator over the elements in this map in descending key order.
+     */
+    Iterator descendingIterator() {
+        return Iterator(this, true);
+    }
+
+    /**
+     * Returns a read-only iterator over the elements in this map in
+     * descending key order.
+     */
+    ConstIterator descendingIterator() const {
+        return ConstIterator(this, true);
+    }
     
     /**
      * TODO Removes all of the mappings from this map.
      */
     void clear() {
         iSize = 0;
-        removeTree(TreapRoot);
+        releaseNodes();
     }
     
     /**
@@ -248,9 +804,8 @@ public:
      * TODO Returns true if this map maps one or more keys to the specified value.
      */
     bool containsValue(const V &value) const {
-        for(Iterator itr = iterator(); itr.hasNext();){
-            Entry tmp = itr.next();
-            if(tmp.getValue() == value) return true;
+        for(ConstIterator itr = iterator(); itr.hasNext();){
+            if(itr.next().getValue() == value) return true;
         }
         return false;
     }
@@ -264,6 +819,34 @@ public:
         return get(key,TreapRoot);
     }
     
+    /**
+     * Returns the entry mapped to key, or NULL if the key is not present.
+     * Unlike get, a miss does not throw.
+     */
+    const Entry *find(const K &key) const {
+        TreapNode *tmp = lookup(key,TreapRoot);
+        return tmp == NULL ? NULL : &tmp->data;
+    }
+
+    /**
+     * Copies the value mapped to key into value and returns true, or
+     * returns false and leaves value untouched if the key is not present.
+     */
+    bool tryGet(const K &key, V &value) const {
+        const Entry *tmp = find(key);
+        if(tmp == NULL) return false;
+        value = tmp->getValue();
+        return true;
+    }
+
+    /**
+     * Returns the value mapped to key, or defaultValue if the key is not present.
+     */
+    V getOrDefault(const K &key, const V &defaultValue) const {
+        const Entry *tmp = find(key);
+        return tmp == NULL ? defaultValue : tmp->getValue();
+    }
+
     /**
      * TODO Returns true if this map contains no key-value mappings.
      */
@@ -275,7 +858,34 @@ public:
      * TODO Associates the specified value with the specified key in this map.
      */
     void put(const K &key, const V &value) {
-        insert(key,value,TreapRoot);
+        ValueMaker make(value);
+        bool inserted = false;
+        TreapNode *tmp = locate(key,make,TreapRoot,inserted);
+        if(!inserted){
+            tmp->data.setValue(value);
+            pullUp(tmp);
+        }
+    }
+
+    /**
+     * Associates the specified value with the specified key only if the key
+     * is not already mapped. Returns true if the value was put.
+     */
+    bool putIfAbsent(const K &key, const V &value) {
+        ValueMaker make(value);
+        bool inserted = false;
+        locate(key,make,TreapRoot,inserted);
+        return inserted;
+    }
+
+    /**
+     * Returns the value mapped to key, first mapping it to fn(key) if the
+     * key is absent. fn is only called when the key is absent.
+     */
+    template<class F>
+    const V &computeIfAbsent(const K &key, F fn) {
+        bool inserted = false;
+        return locate(key,fn,TreapRoot,inserted)->data.getValue();
     }
     
     /**
@@ -284,7 +894,9 @@ public:
      * @throw ElementNotExist
      */
     void remove(const K &key) {
-        if(!remove(key,TreapRoot)) throw ElementNotExist();
+        TreapNode *tmp = lookup(key,TreapRoot);
+        if(tmp == NULL) throw ElementNotExist();
+        removeNode(tmp);
     }
     
     /**
@@ -293,6 +905,213 @@ public:
     int size() const {
         return iSize;
     }
+
+    /**
+     * Returns the entry with the greatest key less than or equal to key,
+     * or NULL if there is none.
+     */
+    const Entry *floorEntry(const K &key) const {
+        TreapNode *tmp = floorNode(key, false);
+        return tmp == NULL ? NULL : &tmp->data;
+    }
+
+    /**
+     * Returns the entry with the least key greater than or equal to key,
+     * or NULL if there is none.
+     */
+    const Entry *ceilingEntry(const K &key) const {
+        TreapNode *tmp = ceilingNode(key, false);
+        return tmp == NULL ? NULL : &tmp->data;
+    }
+
+    /**
+     * Returns the entry with the least key strictly greater than key,
+     * or NULL if there is none.
+     */
+    const Entry *higherEntry(const K &key) const {
+        TreapNode *tmp = ceilingNode(key, true);
+        return tmp == NULL ? NULL : &tmp->data;
+    }
+
+    /**
+     * Returns the entry with the greatest key strictly less than key,
+     * or NULL if there is none.
+     */
+    const Entry *lowerEntry(const K &key) const {
+        TreapNode *tmp = floorNode(key, true);
+        return tmp == NULL ? NULL : &tmp->data;
+    }
+
+    /**
+     * Returns the entry with the least key, or NULL if this map is empty.
+     */
+    const Entry *firstEntry() const {
+        TreapNode *tmp = findMin(TreapRoot);
+        return tmp == NULL ? NULL : &tmp->data;
+    }
+
+    /**
+     * Returns the entry with the greatest key, or NULL if this map is empty.
+     */
+    const Entry *lastEntry() const {
+        TreapNode *tmp = findMax(TreapRoot);
+        return tmp == NULL ? NULL : &tmp->data;
+    }
+
+    /**
+     * Removes the entry with the least key and returns a copy of it.
+     * @throw ElementNotExist if this map is empty
+     */
+    Entry pollFirst() {
+        TreapNode *tmp = findMin(TreapRoot);
+        if(tmp == NULL) throw ElementNotExist();
+        Entry result = tmp->data;
+        removeNode(tmp);
+        return result;
+    }
+
+    /**
+     * Removes the entry with the greatest key and returns a copy of it.
+     * @throw ElementNotExist if this map is empty
+     */
+    Entry pollLast() {
+        TreapNode *tmp = findMax(TreapRoot);
+        if(tmp == NULL) throw ElementNotExist();
+        Entry result = tmp->data;
+        removeNode(tmp);
+        return result;
+    }
+
+    /**
+     * Returns the entry with the k-th smallest key, counting from 0, in O(log n).
+     * @throw IndexOutOfBound
+     */
+    const Entry &select(int k) const {
+        if(k < 0 || k >= iSize) throw IndexOutOfBound();
+        TreapNode *root = TreapRoot;
+        while(k != sizeOf(root->lf)){
+            if(k < sizeOf(root->lf)) root = root->lf;
+            else {
+                k -= sizeOf(root->lf) + 1;
+                root = root->rt;
+            }
+        }
+        return root->data;
+    }
+
+    /**
+     * Returns the number of keys strictly less than key in O(log n).
+     */
+    int rank(const K &key) const {
+        int cnt = 0;
+        for(TreapNode *root = TreapRoot; root != NULL;){
+            if(root->data.getKey() < key){
+                cnt += sizeOf(root->lf) + 1;
+                root = root->rt;
+            }
+            else root = root->lf;
+        }
+        return cnt;
+    }
+
+    /**
+     * Returns the number of keys in [lo, hi) in O(log n).
+     */
+    int countRange(const K &lo, const K &hi) const {
+        int cnt = rank(hi) - rank(lo);
+        return cnt > 0 ? cnt : 0;
+    }
+
+    /**
+     * Returns the aggregate of the values whose keys lie in [lo, hi), combined
+     * in key order, in O(log n). An empty range gives A::identity().
+     */
+    Aggregate aggregate(const K &lo, const K &hi) const {
+        const TreapNode *root = TreapRoot;
+        while(root != NULL){
+            if(root->data.getKey() < lo) root = root->rt;
+            else if(!(root->data.getKey() < hi)) root = root->lf;
+            else return A::combine(A::combine(aggregateFrom(root->lf, lo), A::lift(root->data.getValue())), aggregateBelow(root->rt, hi));
+        }
+        return A::identity();
+    }
+
+    /**
+     * Returns the aggregate of all values in this map in O(1).
+     */
+    Aggregate aggregate() const {
+        return aggregateOf(TreapRoot);
+    }
+
+    /**
+     * Moves every mapping whose key is not less than key into a new map and
+     * returns it, in O(log n). The nodes are not copied: the new map's pool
+     * shares the slabs of this one (see NodePool::share), so neither map
+     * frees that memory until both have released it, and each split adds
+     * O(1) to the cost of the next one.
+     */
+    TreeMap splitAt(const K &key) {
+        TreeMap result;
+        result.iPool.share(iPool);
+        split(TreapRoot, key, false, TreapRoot, result.TreapRoot);
+        iSize = sizeOf(TreapRoot);
+        result.iSize = sizeOf(result.TreapRoot);
+        return result;
+    }
+
+    /**
+     * Puts every mapping of x into this map; on equal keys the value of x wins.
+     * Large subtrees are processed in parallel by up to threads threads.
+     */
+    void unionWith(const TreeMap &x, int threads = 1) {
+        if(this == &x) return;
+        TreapRoot = unite(iPool, TreapRoot, x.TreapRoot, threads);
+        iSize = sizeOf(TreapRoot);
+    }
+
+    /**
+     * Removes every mapping whose key is not in x.
+     * Large subtrees are processed in parallel by up to threads threads.
+     */
+    void intersectWith(const TreeMap &x, int threads = 1) {
+        if(this == &x) return;
+        TreapRoot = intersect(iPool, TreapRoot, x.TreapRoot, threads);
+        iSize = sizeOf(TreapRoot);
+    }
+
+    /**
+     * Removes every mapping whose key is in x.
+     * Large subtrees are processed in parallel by up to threads threads.
+     */
+    void difference(const TreeMap &x, int threads = 1) {
+        if(this == &x){
+            clear();
+            return;
+        }
+        TreapRoot = subtract(iPool, TreapRoot, x.TreapRoot, threads);
+        iSize = sizeOf(TreapRoot);
+    }
+
+    /**
+     * Returns a view of the mappings whose keys lie in [lo, hi).
+     */
+    SubMap subMap(const K &lo, const K &hi) const {
+        return SubMap(this, &lo, &hi);
+    }
+
+    /**
+     * Returns a view of the mappings whose keys are less than hi.
+     */
+    SubMap headMap(const K &hi) const {
+        return SubMap(this, NULL, &hi);
+    }
+
+    /**
+     * Returns a view of the mappings whose keys are greater than or equal to lo.
+     */
+    SubMap tailMap(const K &lo) const {
+        return SubMap(this, &lo, NULL);
+    }
 };
 
 #endif
@@ -0,0 +1,74 @@
+/** @file
+ * Insert-in-middle, remove-from-middle and growth throughput of ArrayList,
+ * for a trivially copyable element (memmove and realloc) against the same
+ * int wrapped in a type with a user-provided copy constructor, which takes
+ * the element-by-element path every type took before the fast path.
+ *
+ *     g++ -std=c++11 -O2 -I.. ArrayListBench.cpp -o ArrayListBench
+ *     ./ArrayListBench [elements...]
+ *
+ * The sizes default to 1K, 100K and 1M elements.
+ */
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "ArrayList.h"
+
+struct Boxed{
+    int value;
+    Boxed(int v = 0):value(v){}
+    Boxed(const Boxed &x):value(x.value){}
+    Boxed &operator=(const Boxed &x){
+        value = x.value;
+        return *this;
+    }
+};
+
+static volatile long sink;
+
+static double seconds(std::chrono::steady_clock::time_point since){
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - since).count();
+}
+
+/**
+ * Grows a list to n elements by add, then inserts and removes n / 10
+ * elements around its middle. Prints ns per add and per middle operation.
+ */
+template<class T>
+static void run(const char *name, int n){
+    int rounds = n >= 1000000 ? 1 : 1000000 / n;
+    int middle = n / 10 > 0 ? n / 10 : 1;
+    double grow = 0, insert = 0, remove = 0;
+    for(int r=0; r<rounds; ++r){
+        ArrayList<T> list;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for(int i=0; i<n; ++i) list.add(T(i));
+        grow += seconds(start);
+        start = std::chrono::steady_clock::now();
+        for(int i=0; i<middle; ++i) list.add(list.size() / 2, T(i));
+        insert += seconds(start);
+        start = std::chrono::steady_clock::now();
+        for(int i=0; i<middle; ++i) list.removeIndex(list.size() / 2);
+        remove += seconds(start);
+        sink += list.size();
+    }
+    printf("%9d  %-8s add %6.2f  add(middle) %9.1f  removeIndex(middle) %9.1f ns/op\n", n, name,
+        grow * 1e9 / n / rounds, insert * 1e9 / middle / rounds, remove * 1e9 / middle / rounds);
+}
+
+int main(int argc, char **argv){
+    std::vector<int> sizes;
+    for(int i=1; i<argc; ++i) sizes.push_back(atoi(argv[i]));
+    if(sizes.empty()){
+        sizes.push_back(1000);
+        sizes.push_back(100000);
+        sizes.push_back(1000000);
+    }
+    for(size_t s=0; s<sizes.size(); ++s){
+        run<int>("int", sizes[s]);
+        run<Boxed>("Boxed", sizes[s]);
+    }
+    return 0;
+}
@@ -0,0 +1,93 @@
+/** @file
+ * BPlusTreeMap against the TreeMap treap: random put, random get, a full
+ * ordered scan and a bulk load from sorted input, in nanoseconds per key.
+ *
+ *     g++ -std=c++11 -O2 -I.. BPlusTreeMapBench.cpp -o BPlusTreeMapBench
+ *     ./BPlusTreeMapBench [-t maxTreapKeys] [keys...]
+ *
+ * The sizes default to 1K, 1M and 100M keys. Small sizes are repeated
+ * until about 10M keys have been processed. A treap node takes about 50
+ * bytes, so -t skips the treap above the given size on small machines.
+ */
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "BPlusTreeMap.h"
+#include "TreeMap.h"
+
+static volatile long sink;
+
+static double seconds(std::chrono::steady_clock::time_point since){
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - since).count();
+}
+
+static unsigned int nextRandom(unsigned int &state){
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+struct Pair{
+    int key;
+    int value;
+    int getKey() const { return key; }
+    int getValue() const { return value; }
+};
+
+template<class Map>
+static void run(const char *name, const std::vector<int> &keys, int rounds){
+    int n = keys.size();
+    double put = 0, get = 0, scan = 0, load = 0;
+    std::vector<Pair> sorted(n);
+    for(int i=0; i<n; ++i) sorted[i] = Pair{ 2 * i, i };
+    for(int r=0; r<rounds; ++r){
+        Map map;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for(int i=0; i<n; ++i) map.put(keys[i], i);
+        put += seconds(start);
+        start = std::chrono::steady_clock::now();
+        long sum = 0;
+        for(int i=n-1; i>=0; --i) sum += map.get(keys[i]);
+        get += seconds(start);
+        start = std::chrono::steady_clock::now();
+        for(typename Map::Iterator itr = map.iterator(); itr.hasNext(); ) sum += itr.next().getValue();
+        scan += seconds(start);
+        map.clear();
+        start = std::chrono::steady_clock::now();
+        Map bulk = Map::fromSorted(sorted.begin(), sorted.end());
+        load += seconds(start);
+        sink += sum + bulk.size();
+    }
+    double keysDone = static_cast<double>(n) * rounds / 1e9;
+    printf("%11d  %-12s put %7.1f  get %7.1f  scan %6.1f  fromSorted %6.1f ns/key\n",
+        n, name, put / keysDone, get / keysDone, scan / keysDone, load / keysDone);
+}
+
+int main(int argc, char **argv){
+    long treapLimit = -1;
+    std::vector<long> sizes;
+    for(int i=1; i<argc; ++i){
+        if(strcmp(argv[i], "-t") == 0 && i + 1 < argc) treapLimit = atol(argv[++i]);
+        else sizes.push_back(atol(argv[i]));
+    }
+    if(sizes.empty()){
+        sizes.push_back(1000);
+        sizes.push_back(1000000);
+        sizes.push_back(100000000);
+    }
+    for(size_t s=0; s<sizes.size(); ++s){
+        int n = static_cast<int>(sizes[s]);
+        int rounds = n >= 10000000 ? 1 : 10000000 / n;
+        std::vector<int> keys(n);
+        unsigned int state = 2463534242u;
+        for(int i=0; i<n; ++i) keys[i] = static_cast<int>(nextRandom(state) & 0x7fffffff);
+        run<BPlusTreeMap<int, int> >("BPlusTreeMap", keys, rounds);
+        if(treapLimit < 0 || n <= treapLimit) run<TreeMap<int, int> >("TreeMap", keys, rounds);
+        else printf("%11d  %-12s skipped (-t %ld)\n", n, "TreeMap", treapLimit);
+    }
+    return 0;
+}
@@ -0,0 +1,123 @@
+/** @file
+ * Contention benchmark: ConcurrentTreeMap against a TreeMap behind one
+ * std::mutex, the setup it replaces. Each thread runs a random mix of get,
+ * put and remove over a shared key range, half of it present at the start.
+ * Prints the total throughput for every thread count and read ratio.
+ *
+ *     g++ -std=c++11 -O2 -pthread -I.. ConcurrentTreeMapBench.cpp -o ConcurrentTreeMapBench
+ *     ./ConcurrentTreeMapBench [keys] [opsPerThread] [maxThreads]
+ *
+ * Defaults: 1M keys, 1M operations per thread, and threads from 1 up to
+ * twice the number of hardware threads, doubling.
+ */
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "ConcurrentTreeMap.h"
+#include "TreeMap.h"
+
+static unsigned int nextRandom(unsigned int &state){
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+struct LockedTreeMap{
+    std::mutex lock;
+    TreeMap<int, int> map;
+
+    bool get(int key, int &value){
+        std::lock_guard<std::mutex> guard(lock);
+        const TreeMap<int, int>::Entry *tmp = map.find(key);
+        if(tmp == NULL) return false;
+        value = tmp->getValue();
+        return true;
+    }
+    void put(int key, int value){
+        std::lock_guard<std::mutex> guard(lock);
+        map.put(key, value);
+    }
+    void remove(int key){
+        std::lock_guard<std::mutex> guard(lock);
+        if(map.containsKey(key)) map.remove(key);
+    }
+};
+
+struct Concurrent{
+    ConcurrentTreeMap<int, int> map;
+
+    bool get(int key, int &value){
+        return map.tryGet(key, value);
+    }
+    void put(int key, int value){
+        map.put(key, value);
+    }
+    /**
+     * Another thread may remove the key between the check and the remove,
+     * which is rare enough for the exception not to show in the timings.
+     */
+    void remove(int key){
+        if(!map.containsKey(key)) return;
+        try{
+            map.remove(key);
+        }
+        catch(ElementNotExist&){
+        }
+    }
+};
+
+static std::atomic<long> sink(0);
+
+/**
+ * Returns millions of operations per second over all threads.
+ */
+template<class Map>
+static double run(int keys, int ops, int threads, int readPercent){
+    Map map;
+    unsigned int state = 88172645u;
+    for(int i=0; i<keys / 2; ++i) map.put(static_cast<int>(nextRandom(state) % keys), i);
+    std::vector<std::thread> workers;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for(int t=0; t<threads; ++t){
+        workers.push_back(std::thread([&map, keys, ops, readPercent, t]{
+            unsigned int random = 2463534242u + 7919u * t;
+            long found = 0;
+            for(int i=0; i<ops; ++i){
+                int key = static_cast<int>(nextRandom(random) % keys);
+                int dice = static_cast<int>(nextRandom(random) % 100);
+                int value;
+                if(dice < readPercent) found += map.get(key, value);
+                else if(dice % 2 == 0) map.put(key, i);
+                else map.remove(key);
+            }
+            sink.fetch_add(found, std::memory_order_relaxed);
+        }));
+    }
+    for(size_t t=0; t<workers.size(); ++t) workers[t].join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return static_cast<double>(ops) * threads / seconds / 1e6;
+}
+
+int main(int argc, char **argv){
+    int keys = argc > 1 ? atoi(argv[1]) : 1000000;
+    int ops = argc > 2 ? atoi(argv[2]) : 1000000;
+    int hardware = static_cast<int>(std::thread::hardware_concurrency());
+    int maxThreads = argc > 3 ? atoi(argv[3]) : 2 * (hardware > 0 ? hardware : 1);
+    static const int readPercents[] = { 100, 90, 50, 10 };
+    printf("%d keys, %d ops per thread, %d hardware threads; Mops/s\n", keys, ops, hardware);
+    printf("threads  read%%  ConcurrentTreeMap  mutex+TreeMap\n");
+    for(int threads=1; threads<=maxThreads; threads *= 2){
+        for(int r=0; r<4; ++r){
+            double concurrent = run<Concurrent>(keys, ops, threads, readPercents[r]);
+            double locked = run<LockedTreeMap>(keys, ops, threads, readPercents[r]);
+            printf("%7d  %5d  %17.2f  %13.2f\n", threads, readPercents[r], concurrent, locked);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,82 @@
+/** @file
+ * TieredArrayList against the shifting ArrayList on editing workloads:
+ * inserts and removes at random positions, inserts at a moving cursor,
+ * and random get, in nanoseconds per operation.
+ *
+ *     g++ -std=c++11 -O2 -I.. TieredArrayListBench.cpp -o TieredArrayListBench
+ *     ./TieredArrayListBench [elements...]
+ *
+ * The sizes default to 10K, 1M and 4M elements; each list is filled with
+ * add first, which is not timed. Sizes under 1M run 200K operations of each
+ * kind, so the random inserts grow them to about 210K; larger ones run 20K.
+ */
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "ArrayList.h"
+#include "TieredArrayList.h"
+
+static volatile long sink;
+
+static unsigned int nextRandom(unsigned int &state){
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+static double nanosPerOp(std::chrono::steady_clock::time_point since, int ops){
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - since).count() / ops;
+}
+
+template<class List>
+static void run(const char *name, int n){
+    List list;
+    for(int i=0; i<n; ++i) list.add(i);
+    int ops = n >= 1000000 ? 20000 : 200000;
+    unsigned int state = 2463534242u;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for(int i=0; i<ops; ++i) list.add(static_cast<int>(nextRandom(state) % (list.size() + 1)), i);
+    double insert = nanosPerOp(start, ops);
+
+    start = std::chrono::steady_clock::now();
+    for(int i=0; i<ops; ++i) list.removeIndex(static_cast<int>(nextRandom(state) % list.size()));
+    double remove = nanosPerOp(start, ops);
+
+    int cursor = list.size() / 3;
+    start = std::chrono::steady_clock::now();
+    for(int i=0; i<ops; ++i){
+        list.add(cursor, i);
+        cursor += 1 + static_cast<int>(nextRandom(state) % 3) - 1;
+        if(cursor > list.size()) cursor = list.size();
+    }
+    double typing = nanosPerOp(start, ops);
+
+    long sum = 0;
+    int gets = 1000000;
+    start = std::chrono::steady_clock::now();
+    for(int i=0; i<gets; ++i) sum += list.get(static_cast<int>(nextRandom(state) % list.size()));
+    double get = nanosPerOp(start, gets);
+    sink += sum;
+
+    printf("%9d  %-16s add(random) %9.1f  removeIndex(random) %9.1f  add(cursor) %9.1f  get %5.1f ns/op\n",
+        n, name, insert, remove, typing, get);
+}
+
+int main(int argc, char **argv){
+    std::vector<int> sizes;
+    for(int i=1; i<argc; ++i) sizes.push_back(atoi(argv[i]));
+    if(sizes.empty()){
+        sizes.push_back(10000);
+        sizes.push_back(1000000);
+        sizes.push_back(4000000);
+    }
+    for(size_t s=0; s<sizes.size(); ++s){
+        run<TieredArrayList<int> >("TieredArrayList", sizes[s]);
+        run<ArrayList<int> >("ArrayList", sizes[s]);
+    }
+    return 0;
+}
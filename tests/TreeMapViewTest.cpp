@@ -0,0 +1,58 @@
+/** @file
+ * Iterates TreeMap views that are temporaries, as in
+ * m.subMap(lo, hi).iterator(), so that the iterator outlives its view.
+ * Run it under AddressSanitizer to catch reads of the dead view:
+ *
+ *     g++ -std=c++11 -g -fsanitize=address -I.. TreeMapViewTest.cpp -o TreeMapViewTest
+ *     ./TreeMapViewTest
+ */
+#include <cstdio>
+#include <cstdlib>
+
+#include "TreeMap.h"
+
+static int failures = 0;
+
+static void check(bool ok, const char *what){
+    if(!ok){
+        printf("FAILED: %s\n", what);
+        ++failures;
+    }
+}
+
+template<class Iter>
+static int sumKeys(Iter itr, int &count){
+    int sum = 0;
+    count = 0;
+    while(itr.hasNext()){
+        sum += itr.next().getKey();
+        ++count;
+    }
+    return sum;
+}
+
+int main(){
+    TreeMap<int, int> map;
+    for(int i=0; i<10; ++i) map.put(i, i * i);
+
+    int count;
+    int sum = sumKeys(map.subMap(2, 7).iterator(), count);
+    check(count == 5 && sum == 2 + 3 + 4 + 5 + 6, "subMap(2, 7)");
+
+    sum = sumKeys(map.headMap(3).iterator(), count);
+    check(count == 3 && sum == 0 + 1 + 2, "headMap(3)");
+
+    sum = sumKeys(map.tailMap(8).iterator(), count);
+    check(count == 2 && sum == 8 + 9, "tailMap(8)");
+
+    TreeMap<int, int>::SubMap::Iterator itr = map.subMap(4, 6).iterator();
+    check(itr.hasNext() && itr.next().getKey() == 4, "stored subMap iterator, first");
+    check(itr.hasNext() && itr.next().getKey() == 5, "stored subMap iterator, second");
+    check(!itr.hasNext(), "stored subMap iterator, end");
+
+    sum = sumKeys(map.subMap(20, 30).iterator(), count);
+    check(count == 0, "empty subMap");
+
+    if(failures == 0) printf("OK\n");
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}